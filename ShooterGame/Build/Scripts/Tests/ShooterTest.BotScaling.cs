@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using EpicGame;
+using Gauntlet;
+
+namespace ShooterTest
+{
+	/// <summary>
+	/// Headless benchmark of bot target acquisition. A standalone client loads a map without rendering,
+	/// adds bots in steps up to 100, times closest enemy queries with and without the enemy index, and writes timings as JSON.
+	/// </summary>
+	public class BotScaling : EpicGameTestNode<ShooterTestConfig>
+	{
+		[AutoParam]
+		public string BenchmarkMap = "Highrise";
+
+		[AutoParam]
+		public string BenchmarkBotCounts = "10,25,50,100";
+
+		[AutoParam]
+		public int BenchmarkFrames = 60;
+
+		public BotScaling(UnrealTestContext InContext) : base(InContext)
+		{
+		}
+
+		public override ShooterTestConfig GetConfiguration()
+		{
+			ShooterTestConfig Config = base.GetConfiguration();
+			Config.NoMCP = true;
+
+			UnrealTestRole Client = Config.RequireRole(UnrealTargetRole.Client);
+			Client.MapOverride = BenchmarkMap;
+			Client.CommandLine += string.Format(" -nullrhi -BenchmarkBotCounts={0} -BenchmarkFrames={1}", BenchmarkBotCounts, BenchmarkFrames);
+			Client.Controllers.Add("BotScaling");
+
+			return Config;
+		}
+	}
+}
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using EpicGame;
+using Gauntlet;
+
+namespace ShooterTest
+{
+	/// <summary>
+	/// Headless benchmark of movement abilities. A standalone client loads a map without rendering,
+	/// spawns bots that loop through Teleport, WallJump, JetpackSprint and WallRun, and writes timings, trace counts and allocations as JSON.
+	/// </summary>
+	public class MovementBenchmark : EpicGameTestNode<ShooterTestConfig>
+	{
+		[AutoParam]
+		public string BenchmarkMap = "Highrise";
+
+		[AutoParam]
+		public int BenchmarkPawns = 32;
+
+		[AutoParam]
+		public int BenchmarkSeconds = 30;
+
+		public MovementBenchmark(UnrealTestContext InContext) : base(InContext)
+		{
+		}
+
+		public override ShooterTestConfig GetConfiguration()
+		{
+			ShooterTestConfig Config = base.GetConfiguration();
+			Config.NoMCP = true;
+
+			UnrealTestRole Client = Config.RequireRole(UnrealTargetRole.Client);
+			Client.MapOverride = BenchmarkMap;
+			Client.CommandLine += string.Format(" -nullrhi -BenchmarkMallocCounter -BenchmarkPawns={0} -BenchmarkSeconds={1}", BenchmarkPawns, BenchmarkSeconds);
+			Client.Controllers.Add("MovementBenchmark");
+
+			return Config;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using EpicGame;
+using Gauntlet;
+
+namespace ShooterTest
+{
+	/// <summary>
+	/// Checks that JetpackSprint physics give the same result on a client and on a dedicated server with fixed ability substeps.
+	/// The client runs without rendering at several capped and jittered frame rates, and the server corrects every move it checks,
+	/// so that its result can be compared with the client's replayed result.
+	/// </summary>
+	public class MovementDeterminism : EpicGameTestNode<ShooterTestConfig>
+	{
+		[AutoParam]
+		public string DeterminismMap = "Highrise";
+
+		[AutoParam]
+		public float DeterminismTolerance = 1.0f;
+
+		public MovementDeterminism(UnrealTestContext InContext) : base(InContext)
+		{
+		}
+
+		public override ShooterTestConfig GetConfiguration()
+		{
+			ShooterTestConfig Config = base.GetConfiguration();
+			Config.PreAssignAccount = false;
+			Config.NoMCP = true;
+
+			UnrealTestRole Client = Config.RequireRole(UnrealTargetRole.Client);
+			UnrealTestRole Server = Config.RequireRole(UnrealTargetRole.Server);
+
+			Server.MapOverride = DeterminismMap;
+			Server.Controllers.Add("MovementDeterminism");
+
+			Client.CommandLine += string.Format(" -nullrhi -DeterminismTolerance={0}", DeterminismTolerance);
+			Client.Controllers.Add("MovementDeterminism");
+
+			return Config;
+		}
+	}
+}
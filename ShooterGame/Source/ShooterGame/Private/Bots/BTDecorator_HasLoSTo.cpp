@@ -7,6 +7,7 @@
 #include "BehaviorTree/Blackboard/BlackboardKeyType_Vector.h"
 #include "Bots/ShooterBot.h"
 #include "Bots/ShooterAIController.h"
+#include "Bots/ShooterVisibilityCache.h"
 #include "Online/ShooterPlayerState.h"
 
 UBTDecorator_HasLoSTo::UBTDecorator_HasLoSTo(const FObjectInitializer& ObjectInitializer)
@@ -109,19 +110,31 @@ bool UBTDecorator_HasLoSTo::LOSTrace(AActor* InActor, AActor* InEnemyActor, cons
 	{
 		if (MyBot != NULL)
 		{
-			// Perform trace to retrieve hit info
-			FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(AILosTrace), true, InActor);
-			
-			TraceParams.bReturnPhysicalMaterial = true;
-			TraceParams.AddIgnoredActor(MyBot);
 			const FVector StartLocation = MyBot->GetActorLocation();
 			FHitResult Hit(ForceInit);
-			GetWorld()->LineTraceSingleByChannel(Hit, StartLocation, EndLocation, COLLISION_WEAPON, TraceParams);
+			AActor* HitActor = NULL;
+
+			UShooterVisibilityCache* VisibilityCache = InEnemyActor ? UShooterVisibilityCache::Get(MyBot) : NULL;
+			if (VisibilityCache)
+			{
+				// Actor targets share the bot's cached weapon LOS trace, from the eyes
+				Hit.bBlockingHit = VisibilityCache->GetHitActor(MyBot, InEnemyActor, HitActor, InEnemyActor == MyController->GetEnemy()) && HitActor != NULL;
+			}
+			else
+			{
+				// Perform trace to retrieve hit info
+				FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(AILosTrace), true, InActor);
+			
+				TraceParams.bReturnPhysicalMaterial = true;
+				TraceParams.AddIgnoredActor(MyBot);
+				GetWorld()->LineTraceSingleByChannel(Hit, StartLocation, EndLocation, COLLISION_WEAPON, TraceParams);
+				HitActor = Hit.GetActor();
+			}
+
 			if (Hit.bBlockingHit == true)
 			{
 				// We hit something. If we have an actor supplied, just check if the hit actor is an enemy. If it is consider that 'has LOS'
-				AActor* HitActor = Hit.GetActor();
-				if (Hit.GetActor() != NULL)
+				if (HitActor != NULL)
 				{
 					// If the hit is our target actor consider it LOS
 					if (HitActor == InActor)
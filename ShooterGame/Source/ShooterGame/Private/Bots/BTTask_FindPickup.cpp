@@ -8,11 +8,13 @@
 #include "Bots/ShooterAIController.h"
 #include "Bots/ShooterBot.h"
 #include "Pickups/ShooterPickup_Ammo.h"
+#include "Pickups/ShooterPickupRegistry.h"
 #include "Weapons/ShooterWeapon_Instant.h"
 
 UBTTask_FindPickup::UBTTask_FindPickup(const FObjectInitializer& ObjectInitializer) 
 	: Super(ObjectInitializer)
 {
+	bRankByPathCost = false;
 }
 
 EBTNodeResult::Type UBTTask_FindPickup::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
@@ -31,19 +33,31 @@ EBTNodeResult::Type UBTTask_FindPickup::ExecuteTask(UBehaviorTreeComponent& Owne
 	}
 
 	const FVector MyLoc = MyBot->GetActorLocation();
-	AShooterPickup_Ammo* BestPickup = NULL;
+	AShooterPickup* BestPickup = NULL;
 	float BestDistSq = MAX_FLT;
 
-	for (int32 i = 0; i < GameMode->LevelPickups.Num(); ++i)
+	UShooterPickupRegistry* PickupRegistry = UShooterPickupRegistry::Get(MyBot);
+	if (PickupRegistry)
 	{
-		AShooterPickup_Ammo* AmmoPickup = Cast<AShooterPickup_Ammo>(GameMode->LevelPickups[i]);
-		if (AmmoPickup && AmmoPickup->IsForWeapon(AShooterWeapon_Instant::StaticClass()) && AmmoPickup->CanBePickedUp(MyBot))
+		BestPickup = PickupRegistry->FindNearestPickup(MyBot, MyLoc, [](AShooterPickup* Pickup)
 		{
-			const float DistSq = (AmmoPickup->GetActorLocation() - MyLoc).SizeSquared();
-			if (BestDistSq == -1 || DistSq < BestDistSq)
+			AShooterPickup_Ammo* AmmoPickup = Cast<AShooterPickup_Ammo>(Pickup);
+			return AmmoPickup && AmmoPickup->IsForWeapon(AShooterWeapon_Instant::StaticClass());
+		}, bRankByPathCost);
+	}
+	else
+	{
+		for (int32 i = 0; i < GameMode->LevelPickups.Num(); ++i)
+		{
+			AShooterPickup_Ammo* AmmoPickup = Cast<AShooterPickup_Ammo>(GameMode->LevelPickups[i]);
+			if (AmmoPickup && AmmoPickup->IsForWeapon(AShooterWeapon_Instant::StaticClass()) && AmmoPickup->CanBePickedUp(MyBot))
 			{
-				BestDistSq = DistSq;
-				BestPickup = AmmoPickup;
+				const float DistSq = (AmmoPickup->GetActorLocation() - MyLoc).SizeSquared();
+				if (BestDistSq == -1 || DistSq < BestDistSq)
+				{
+					BestDistSq = DistSq;
+					BestPickup = AmmoPickup;
+				}
 			}
 		}
 	}
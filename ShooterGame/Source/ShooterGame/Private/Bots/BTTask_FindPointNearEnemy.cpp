@@ -3,6 +3,7 @@
 #include "ShooterGame.h"
 #include "Bots/BTTask_FindPointNearEnemy.h"
 #include "Bots/ShooterAIController.h"
+#include "Bots/ShooterNavQueryBatcher.h"
 #include "BehaviorTree/BehaviorTreeComponent.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "BehaviorTree/Blackboard/BlackboardKeyAllTypes.h"
@@ -16,6 +17,9 @@ UBTTask_FindPointNearEnemy::UBTTask_FindPointNearEnemy(const FObjectInitializer&
 
 EBTNodeResult::Type UBTTask_FindPointNearEnemy::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
 {
+	FBTFindPointNearEnemyMemory* MyMemory = (FBTFindPointNearEnemyMemory*)NodeMemory;
+	MyMemory->RequestId = 0;
+
 	AShooterAIController* MyController = Cast<AShooterAIController>(OwnerComp.GetAIOwner());
 	if (MyController == NULL)
 	{
@@ -29,7 +33,28 @@ EBTNodeResult::Type UBTTask_FindPointNearEnemy::ExecuteTask(UBehaviorTreeCompone
 		const float SearchRadius = 200.0f;
 		const FVector SearchOrigin = Enemy->GetActorLocation() + 600.0f * (MyBot->GetActorLocation() - Enemy->GetActorLocation()).GetSafeNormal();
 		FVector Loc(0);
-		UNavigationSystemV1::K2_GetRandomReachablePointInRadius(MyController, SearchOrigin, Loc, SearchRadius);
+
+		UShooterNavQueryBatcher* Batcher = UShooterNavQueryBatcher::Get(MyController);
+		if (Batcher)
+		{
+			// another bot recently went around the same enemy from the same side
+			if (!Batcher->FindCachedPoint(MyController, Enemy, SearchOrigin, Loc))
+			{
+				TWeakObjectPtr<UBehaviorTreeComponent> WeakOwnerComp(&OwnerComp);
+				const uint32 RequestId = Batcher->RequestPoint(MyController, Enemy, SearchOrigin, SearchRadius, [this, WeakOwnerComp](uint32 Id, bool bFound, const FVector& Point)
+				{
+					OnPointFound(WeakOwnerComp, Id, bFound, Point);
+				});
+
+				MyMemory->RequestId = RequestId;
+				return EBTNodeResult::InProgress;
+			}
+		}
+		else
+		{
+			UNavigationSystemV1::K2_GetRandomReachablePointInRadius(MyController, SearchOrigin, Loc, SearchRadius);
+		}
+
 		if (Loc != FVector::ZeroVector)
 		{
 			OwnerComp.GetBlackboardComponent()->SetValue<UBlackboardKeyType_Vector>(BlackboardKey.GetSelectedKeyID(), Loc);
@@ -39,3 +64,52 @@ EBTNodeResult::Type UBTTask_FindPointNearEnemy::ExecuteTask(UBehaviorTreeCompone
 
 	return EBTNodeResult::Failed;
 }
+
+EBTNodeResult::Type UBTTask_FindPointNearEnemy::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTFindPointNearEnemyMemory* MyMemory = (FBTFindPointNearEnemyMemory*)NodeMemory;
+	if (MyMemory->RequestId)
+	{
+		// the batcher may have been disabled meanwhile, cancel from the world subsystem directly
+		UWorld* World = OwnerComp.GetWorld();
+		UShooterNavQueryBatcher* Batcher = World ? World->GetSubsystem<UShooterNavQueryBatcher>() : nullptr;
+		if (Batcher)
+		{
+			Batcher->CancelRequest(MyMemory->RequestId);
+		}
+		MyMemory->RequestId = 0;
+	}
+
+	return EBTNodeResult::Aborted;
+}
+
+uint16 UBTTask_FindPointNearEnemy::GetInstanceMemorySize() const
+{
+	return sizeof(FBTFindPointNearEnemyMemory);
+}
+
+void UBTTask_FindPointNearEnemy::OnPointFound(TWeakObjectPtr<UBehaviorTreeComponent> OwnerComp, uint32 RequestId, bool bFound, const FVector& Point)
+{
+	if (!OwnerComp.IsValid() || RequestId == 0)
+	{
+		return;
+	}
+
+	FBTFindPointNearEnemyMemory* MyMemory = (FBTFindPointNearEnemyMemory*)OwnerComp->GetNodeMemory(this, OwnerComp->FindInstanceContainingNode(this));
+	if (MyMemory == nullptr || MyMemory->RequestId != RequestId)
+	{
+		return;
+	}
+	MyMemory->RequestId = 0;
+
+	// a failed query leaves the search origin, which the synchronous path moves to as well
+	if (Point != FVector::ZeroVector)
+	{
+		OwnerComp->GetBlackboardComponent()->SetValue<UBlackboardKeyType_Vector>(BlackboardKey.GetSelectedKeyID(), Point);
+		FinishLatentTask(*OwnerComp, EBTNodeResult::Succeeded);
+	}
+	else
+	{
+		FinishLatentTask(*OwnerComp, EBTNodeResult::Failed);
+	}
+}
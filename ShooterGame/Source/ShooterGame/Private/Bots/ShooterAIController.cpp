@@ -3,6 +3,9 @@
 #include "ShooterGame.h"
 #include "Bots/ShooterAIController.h"
 #include "Bots/ShooterBot.h"
+#include "Bots/ShooterEnemyIndex.h"
+#include "Bots/ShooterVisibilityCache.h"
+#include "Bots/ShooterBehaviorTreeComponent.h"
 #include "Online/ShooterPlayerState.h"
 #include "BehaviorTree/BehaviorTree.h"
 #include "BehaviorTree/BehaviorTreeComponent.h"
@@ -11,11 +14,15 @@
 #include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
 #include "Weapons/ShooterWeapon.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon LOS traces"), STAT_ShooterWeaponLOSTraces, STATGROUP_ShooterAI);
+
+uint64 AShooterAIController::WeaponLOSTraceCount = 0;
+
 AShooterAIController::AShooterAIController(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
  	BlackboardComp = ObjectInitializer.CreateDefaultSubobject<UBlackboardComponent>(this, TEXT("BlackBoardComp"));
  	
-	BrainComponent = BehaviorComp = ObjectInitializer.CreateDefaultSubobject<UBehaviorTreeComponent>(this, TEXT("BehaviorComp"));	
+	BrainComponent = BehaviorComp = ObjectInitializer.CreateDefaultSubobject<UShooterBehaviorTreeComponent>(this, TEXT("BehaviorComp"));	
 
 	bWantsPlayerState = true;
 }
@@ -73,6 +80,18 @@ void AShooterAIController::FindClosestEnemy()
 	}
 
 	const FVector MyLoc = MyBot->GetActorLocation();
+
+	if (UShooterEnemyIndex* EnemyIndex = UShooterEnemyIndex::Get(this))
+	{
+		TArray<AShooterCharacter*> NearestEnemies;
+		EnemyIndex->GetNearestEnemies(this, MyLoc, 1, NearestEnemies);
+		if (NearestEnemies.Num() > 0)
+		{
+			SetEnemy(NearestEnemies[0]);
+		}
+		return;
+	}
+
 	float BestDistSq = MAX_FLT;
 	AShooterCharacter* BestPawn = NULL;
 
@@ -102,6 +121,29 @@ bool AShooterAIController::FindClosestEnemyWithLOS(AShooterCharacter* ExcludeEne
 	if (MyBot != NULL)
 	{
 		const FVector MyLoc = MyBot->GetActorLocation();
+
+		if (UShooterEnemyIndex* EnemyIndex = UShooterEnemyIndex::Get(this))
+		{
+			// candidates come nearest first, so the first one in sight is the closest
+			AShooterCharacter* BestPawn = NULL;
+			EnemyIndex->ForEachEnemyByDistance(this, MyLoc, [&](AShooterCharacter* TestPawn)
+			{
+				if (TestPawn != ExcludeEnemy && HasWeaponLOSToEnemy(TestPawn, true))
+				{
+					BestPawn = TestPawn;
+					return false;
+				}
+				return true;
+			});
+
+			if (BestPawn)
+			{
+				SetEnemy(BestPawn);
+				bGotEnemy = true;
+			}
+			return bGotEnemy;
+		}
+
 		float BestDistSq = MAX_FLT;
 		AShooterCharacter* BestPawn = NULL;
 
@@ -135,40 +177,54 @@ bool AShooterAIController::HasWeaponLOSToEnemy(AActor* InEnemyActor, const bool
 	AShooterBot* MyBot = Cast<AShooterBot>(GetPawn());
 
 	bool bHasLOS = false;
-	// Perform trace to retrieve hit info
-	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(AIWeaponLosTrace), true, GetPawn());
+	AActor* HitActor = NULL;
+
+	UShooterVisibilityCache* VisibilityCache = UShooterVisibilityCache::Get(this);
+	if (VisibilityCache)
+	{
+		// Shared with the other checks of this pair, traced asynchronously. The current enemy is refreshed first, ShootEnemy relies on it
+		VisibilityCache->GetHitActor(GetPawn(), InEnemyActor, HitActor, InEnemyActor == GetEnemy());
+	}
+	else
+	{
+		// Perform trace to retrieve hit info
+		FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(AIWeaponLosTrace), true, GetPawn());
 
-	TraceParams.bReturnPhysicalMaterial = true;	
-	FVector StartLocation = MyBot->GetActorLocation();	
-	StartLocation.Z += GetPawn()->BaseEyeHeight; //look from eyes
+		TraceParams.bReturnPhysicalMaterial = true;	
+		FVector StartLocation = MyBot->GetActorLocation();	
+		StartLocation.Z += GetPawn()->BaseEyeHeight; //look from eyes
 	
-	FHitResult Hit(ForceInit);
-	const FVector EndLocation = InEnemyActor->GetActorLocation();
-	GetWorld()->LineTraceSingleByChannel(Hit, StartLocation, EndLocation, COLLISION_WEAPON, TraceParams);
-	if (Hit.bBlockingHit == true)
+		FHitResult Hit(ForceInit);
+		const FVector EndLocation = InEnemyActor->GetActorLocation();
+		WeaponLOSTraceCount++;
+		INC_DWORD_STAT(STAT_ShooterWeaponLOSTraces);
+		GetWorld()->LineTraceSingleByChannel(Hit, StartLocation, EndLocation, COLLISION_WEAPON, TraceParams);
+		if (Hit.bBlockingHit == true)
+		{
+			HitActor = Hit.GetActor();
+		}
+	}
+
+	// Theres a blocking hit - check if its our enemy actor
+	if (HitActor != NULL)
 	{
-		// Theres a blocking hit - check if its our enemy actor
-		AActor* HitActor = Hit.GetActor();
-		if (Hit.GetActor() != NULL)
+		if (HitActor == InEnemyActor)
 		{
-			if (HitActor == InEnemyActor)
-			{
-				bHasLOS = true;
-			}
-			else if (bAnyEnemy == true)
+			bHasLOS = true;
+		}
+		else if (bAnyEnemy == true)
+		{
+			// Its not our actor, maybe its still an enemy ?
+			ACharacter* HitChar = Cast<ACharacter>(HitActor);
+			if (HitChar != NULL)
 			{
-				// Its not our actor, maybe its still an enemy ?
-				ACharacter* HitChar = Cast<ACharacter>(HitActor);
-				if (HitChar != NULL)
+				AShooterPlayerState* HitPlayerState = Cast<AShooterPlayerState>(HitChar->GetPlayerState());
+				AShooterPlayerState* MyPlayerState = Cast<AShooterPlayerState>(PlayerState);
+				if ((HitPlayerState != NULL) && (MyPlayerState != NULL))
 				{
-					AShooterPlayerState* HitPlayerState = Cast<AShooterPlayerState>(HitChar->GetPlayerState());
-					AShooterPlayerState* MyPlayerState = Cast<AShooterPlayerState>(PlayerState);
-					if ((HitPlayerState != NULL) && (MyPlayerState != NULL))
+					if (HitPlayerState->GetTeamNum() != MyPlayerState->GetTeamNum())
 					{
-						if (HitPlayerState->GetTeamNum() != MyPlayerState->GetTeamNum())
-						{
-							bHasLOS = true;
-						}
+						bHasLOS = true;
 					}
 				}
 			}
@@ -0,0 +1,239 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Bots/ShooterAILODManager.h"
+#include "Bots/ShooterBehaviorTreeComponent.h"
+
+static int32 ShooterAILOD = 1;
+FAutoConsoleVariableRef CVarShooterAILOD(
+	TEXT("p.ShooterAILOD"),
+	ShooterAILOD,
+	TEXT("Throttle behavior trees of bots far from human players.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static float ShooterAILODNearDistance = 3000.0f;
+FAutoConsoleVariableRef CVarShooterAILODNearDistance(
+	TEXT("p.ShooterAILODNearDistance"),
+	ShooterAILODNearDistance,
+	TEXT("Bots closer than this to a human player are updated every frame."),
+	ECVF_Default);
+
+static float ShooterAILODFarDistance = 8000.0f;
+FAutoConsoleVariableRef CVarShooterAILODFarDistance(
+	TEXT("p.ShooterAILODFarDistance"),
+	ShooterAILODFarDistance,
+	TEXT("Bots further than this from every human player use the far update interval."),
+	ECVF_Default);
+
+static float ShooterAILODMidInterval = 0.1f;
+FAutoConsoleVariableRef CVarShooterAILODMidInterval(
+	TEXT("p.ShooterAILODMidInterval"),
+	ShooterAILODMidInterval,
+	TEXT("Behavior tree update interval of bots between near and far distance, in seconds."),
+	ECVF_Default);
+
+static float ShooterAILODFarInterval = 0.5f;
+FAutoConsoleVariableRef CVarShooterAILODFarInterval(
+	TEXT("p.ShooterAILODFarInterval"),
+	ShooterAILODFarInterval,
+	TEXT("Behavior tree update interval of far bots, in seconds."),
+	ECVF_Default);
+
+static int32 ShooterAILODBotsPerFrame = 16;
+FAutoConsoleVariableRef CVarShooterAILODBotsPerFrame(
+	TEXT("p.ShooterAILODBotsPerFrame"),
+	ShooterAILODBotsPerFrame,
+	TEXT("Bots whose LOD is recomputed per frame, round robin."),
+	ECVF_Default);
+
+static int32 ShooterAILODThrottledTicks = 8;
+FAutoConsoleVariableRef CVarShooterAILODThrottledTicks(
+	TEXT("p.ShooterAILODThrottledTicks"),
+	ShooterAILODThrottledTicks,
+	TEXT("Maximum behavior tree updates of mid and far bots per frame, the others wait for next frames.\n")
+	TEXT("The bots that waited the longest go first."),
+	ECVF_Default);
+
+/** update intervals after which a waiting bot updates whatever the budget */
+static const float MaxWaitIntervals = 4.0f;
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("AI ms per frame"), STAT_ShooterAIMsPerFrame, STATGROUP_ShooterAI);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("AI us per bot"), STAT_ShooterAIUsPerBot, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bots"), STAT_ShooterAIBots, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bots near"), STAT_ShooterAIBotsNear, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bots mid"), STAT_ShooterAIBotsMid, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bots far"), STAT_ShooterAIBotsFar, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Throttled BT updates"), STAT_ShooterAIThrottledTicks, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overdue BT updates"), STAT_ShooterAIOverdueTicks, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Waiting BT updates"), STAT_ShooterAIWaitingTicks, STATGROUP_ShooterAI);
+
+void UShooterAILODManager::Deinitialize()
+{
+	Bots.Empty();
+	WaitingBots.Empty();
+	GrantedBots.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UShooterAILODManager::IsTickable() const
+{
+	return Bots.Num() > 0;
+}
+
+TStatId UShooterAILODManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterAILODManager, STATGROUP_Tickables);
+}
+
+UShooterAILODManager* UShooterAILODManager::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterAILOD && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterAILODManager>() : nullptr;
+}
+
+float UShooterAILODManager::GetUpdateInterval(EShooterAILOD::Type LOD)
+{
+	switch (LOD)
+	{
+		case EShooterAILOD::Mid:	return ShooterAILODMidInterval;
+		case EShooterAILOD::Far:	return ShooterAILODFarInterval;
+		default:					return 0.0f;
+	}
+}
+
+void UShooterAILODManager::RegisterBot(UShooterBehaviorTreeComponent* BehaviorComp)
+{
+	if (BehaviorComp && GetWorld()->IsGameWorld())
+	{
+		Bots.AddUnique(BehaviorComp);
+	}
+}
+
+void UShooterAILODManager::UnregisterBot(UShooterBehaviorTreeComponent* BehaviorComp)
+{
+	Bots.RemoveSwap(BehaviorComp);
+}
+
+bool UShooterAILODManager::ShouldTick(const UShooterBehaviorTreeComponent* BehaviorComp, float PendingDeltaTime)
+{
+	const EShooterAILOD::Type LOD = BehaviorComp->GetLOD();
+	if (LOD == EShooterAILOD::Near)
+	{
+		return true;
+	}
+
+	const float UpdateInterval = GetUpdateInterval(LOD);
+	if (PendingDeltaTime < UpdateInterval)
+	{
+		return false;
+	}
+
+	// throttled updates that are due share a per frame budget, granted by Tick
+	if (GrantedBots.Remove(FObjectKey(BehaviorComp)) > 0)
+	{
+		INC_DWORD_STAT(STAT_ShooterAIThrottledTicks);
+		return true;
+	}
+
+	// never starve a bot when more of them are due than the budget allows
+	if (PendingDeltaTime >= UpdateInterval * MaxWaitIntervals)
+	{
+		INC_DWORD_STAT(STAT_ShooterAIOverdueTicks);
+		return true;
+	}
+
+	WaitingBots.Emplace(FObjectKey(BehaviorComp), PendingDeltaTime);
+	return false;
+}
+
+EShooterAILOD::Type UShooterAILODManager::ComputeLOD(const APawn* Pawn, const TArray<FVector, TInlineAllocator<8>>& ViewLocations)
+{
+	if (!Pawn)
+	{
+		return EShooterAILOD::Far;
+	}
+
+	float BestDistSq = MAX_FLT;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		BestDistSq = FMath::Min(BestDistSq, FVector::DistSquared(ViewLocation, Pawn->GetActorLocation()));
+	}
+
+	if (BestDistSq < FMath::Square(ShooterAILODNearDistance))
+	{
+		return EShooterAILOD::Near;
+	}
+
+	return BestDistSq < FMath::Square(ShooterAILODFarDistance) ? EShooterAILOD::Mid : EShooterAILOD::Far;
+}
+
+void UShooterAILODManager::Tick(float DeltaTime)
+{
+	// behavior tree time of the frame that just ended
+	const double AIMs = FPlatformTime::ToMilliseconds64(TickCycles);
+	TickCycles = 0;
+
+	UWorld* World = GetWorld();
+
+	TArray<FVector, TInlineAllocator<8>> ViewLocations;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PC = It->Get();
+		if (PC && PC->PlayerState && !PC->PlayerState->IsABot())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	Bots.RemoveAllSwap([](const TWeakObjectPtr<UShooterBehaviorTreeComponent>& Bot) { return !Bot.IsValid(); });
+
+	// disabled at runtime, restore full rate
+	if (!ShooterAILOD)
+	{
+		for (const TWeakObjectPtr<UShooterBehaviorTreeComponent>& Bot : Bots)
+		{
+			Bot->SetLOD(EShooterAILOD::Near);
+		}
+		ViewLocations.Reset();
+	}
+
+	// a few bots per frame, round robin
+	const int32 NumToBucket = ShooterAILOD ? FMath::Min(FMath::Max(ShooterAILODBotsPerFrame, 1), Bots.Num()) : 0;
+	for (int32 i = 0; i < NumToBucket; i++)
+	{
+		NextBucketIndex = NextBucketIndex < Bots.Num() ? NextBucketIndex : 0;
+		UShooterBehaviorTreeComponent* BehaviorComp = Bots[NextBucketIndex++].Get();
+
+		const AController* Controller = Cast<AController>(BehaviorComp->GetOwner());
+		BehaviorComp->SetLOD(ComputeLOD(Controller ? Controller->GetPawn() : nullptr, ViewLocations));
+	}
+
+	// next frame's budget goes to the bots that waited the longest
+	SET_DWORD_STAT(STAT_ShooterAIWaitingTicks, WaitingBots.Num());
+	GrantedBots.Reset();
+	WaitingBots.Sort([](const TPair<FObjectKey, float>& A, const TPair<FObjectKey, float>& B) { return A.Value > B.Value; });
+	const int32 NumToGrant = FMath::Min(FMath::Max(ShooterAILODThrottledTicks, 0), WaitingBots.Num());
+	for (int32 i = 0; i < NumToGrant; i++)
+	{
+		GrantedBots.Add(WaitingBots[i].Key);
+	}
+	WaitingBots.Reset();
+
+	FMemory::Memzero(NumBots);
+	for (const TWeakObjectPtr<UShooterBehaviorTreeComponent>& Bot : Bots)
+	{
+		NumBots[Bot->GetLOD()]++;
+	}
+
+	SET_FLOAT_STAT(STAT_ShooterAIMsPerFrame, AIMs);
+	SET_FLOAT_STAT(STAT_ShooterAIUsPerBot, Bots.Num() ? AIMs * 1000.0 / Bots.Num() : 0.0);
+	SET_DWORD_STAT(STAT_ShooterAIBots, Bots.Num());
+	SET_DWORD_STAT(STAT_ShooterAIBotsNear, NumBots[EShooterAILOD::Near]);
+	SET_DWORD_STAT(STAT_ShooterAIBotsMid, NumBots[EShooterAILOD::Mid]);
+	SET_DWORD_STAT(STAT_ShooterAIBotsFar, NumBots[EShooterAILOD::Far]);
+}
@@ -0,0 +1,69 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Bots/ShooterBehaviorTreeComponent.h"
+
+UShooterBehaviorTreeComponent::UShooterBehaviorTreeComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	LOD = EShooterAILOD::Near;
+	SkippedTime = 0.0f;
+}
+
+void UShooterBehaviorTreeComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UShooterAILODManager* LODManager = GetWorld() ? GetWorld()->GetSubsystem<UShooterAILODManager>() : nullptr;
+	if (LODManager)
+	{
+		LODManager->RegisterBot(this);
+	}
+}
+
+void UShooterBehaviorTreeComponent::OnUnregister()
+{
+	UShooterAILODManager* LODManager = GetWorld() ? GetWorld()->GetSubsystem<UShooterAILODManager>() : nullptr;
+	if (LODManager)
+	{
+		LODManager->UnregisterBot(this);
+	}
+
+	Super::OnUnregister();
+}
+
+void UShooterBehaviorTreeComponent::SetLOD(EShooterAILOD::Type NewLOD)
+{
+	if (LOD != NewLOD)
+	{
+		LOD = NewLOD;
+
+		// focus and control rotation updates follow the tree rate
+		AActor* MyOwner = GetOwner();
+		if (MyOwner)
+		{
+			MyOwner->SetActorTickInterval(UShooterAILODManager::GetUpdateInterval(LOD));
+		}
+	}
+}
+
+void UShooterBehaviorTreeComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	UShooterAILODManager* LODManager = UShooterAILODManager::Get(this);
+	if (LODManager && !LODManager->ShouldTick(this, SkippedTime + DeltaTime))
+	{
+		SkippedTime += DeltaTime;
+		return;
+	}
+
+	const float TickDeltaTime = SkippedTime + DeltaTime;
+	SkippedTime = 0.0f;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	Super::TickComponent(TickDeltaTime, TickType, ThisTickFunction);
+
+	if (LODManager)
+	{
+		LODManager->AddTickCycles(FPlatformTime::Cycles64() - StartCycles);
+	}
+}
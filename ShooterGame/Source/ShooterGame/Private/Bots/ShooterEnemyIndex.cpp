@@ -0,0 +1,169 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Bots/ShooterEnemyIndex.h"
+
+static int32 ShooterEnemyIndex = 1;
+FAutoConsoleVariableRef CVarShooterEnemyIndex(
+	TEXT("p.ShooterEnemyIndex"),
+	ShooterEnemyIndex,
+	TEXT("Bots find enemies through a shared spatial hash, rebuilt once per frame, instead of iterating all characters.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static float ShooterEnemyIndexCellSize = 2000.0f;
+FAutoConsoleVariableRef CVarShooterEnemyIndexCellSize(
+	TEXT("p.ShooterEnemyIndexCellSize"),
+	ShooterEnemyIndexCellSize,
+	TEXT("Size of the enemy index grid cells, in cm."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Enemy index rebuild"), STAT_ShooterEnemyIndexRebuild, STATGROUP_ShooterAI);
+DECLARE_CYCLE_STAT(TEXT("Enemy index query"), STAT_ShooterEnemyIndexQuery, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Indexed characters"), STAT_ShooterEnemyIndexCharacters, STATGROUP_ShooterAI);
+
+void UShooterEnemyIndex::Deinitialize()
+{
+	Entries.Empty();
+	Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+UShooterEnemyIndex* UShooterEnemyIndex::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterEnemyIndex && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterEnemyIndex>() : nullptr;
+}
+
+FIntPoint UShooterEnemyIndex::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UShooterEnemyIndex::Update()
+{
+	if (BuiltFrame == GFrameCounter && Entries.Num() > 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterEnemyIndexRebuild);
+
+	BuiltFrame = GFrameCounter;
+	CellSize = FMath::Max(ShooterEnemyIndexCellSize, 100.0f);
+	Entries.Reset();
+	for (TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+
+	MinCell = FIntPoint(MAX_int32, MAX_int32);
+	MaxCell = FIntPoint(MIN_int32, MIN_int32);
+
+	for (AShooterCharacter* Pawn : TActorRange<AShooterCharacter>(GetWorld()))
+	{
+		if (!Pawn->IsAlive())
+		{
+			continue;
+		}
+
+		const FVector Location = Pawn->GetActorLocation();
+		const FIntPoint Cell = GetCell(Location);
+
+		Cells.FindOrAdd(Cell).Add(Entries.Num());
+		Entries.Add({ Pawn, Location });
+
+		MinCell = FIntPoint(FMath::Min(MinCell.X, Cell.X), FMath::Min(MinCell.Y, Cell.Y));
+		MaxCell = FIntPoint(FMath::Max(MaxCell.X, Cell.X), FMath::Max(MaxCell.Y, Cell.Y));
+	}
+
+	SET_DWORD_STAT(STAT_ShooterEnemyIndexCharacters, Entries.Num());
+}
+
+void UShooterEnemyIndex::ForEachEnemyByDistance(AController* Querier, const FVector& Location, TFunctionRef<bool(AShooterCharacter*)> Visitor)
+{
+	Update();
+
+	if (Entries.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterEnemyIndexQuery);
+
+	// rings of cells around the querier's cell, until the grid bounds are covered
+	const FIntPoint Center = GetCell(Location);
+	const int32 MaxRing = FMath::Max(
+		FMath::Max(FMath::Abs(Center.X - MinCell.X), FMath::Abs(MaxCell.X - Center.X)),
+		FMath::Max(FMath::Abs(Center.Y - MinCell.Y), FMath::Abs(MaxCell.Y - Center.Y)));
+
+	// candidates found but not visited yet, as a min heap on squared distance
+	typedef TPair<float, int32> FCandidate;
+	TArray<FCandidate, TInlineAllocator<64>> Pending;
+	auto CandidateLess = [](const FCandidate& A, const FCandidate& B) { return A.Key < B.Key; };
+
+	auto AddCell = [&](const FIntPoint& Cell)
+	{
+		const TArray<int32>* Indices = Cells.Find(Cell);
+		if (Indices)
+		{
+			for (int32 Index : *Indices)
+			{
+				const FIndexedCharacter& Entry = Entries[Index];
+				if (!Entry.Pawn->IsPendingKill() && Entry.Pawn->IsAlive() && Entry.Pawn->IsEnemyFor(Querier))
+				{
+					Pending.HeapPush(FCandidate((Entry.Location - Location).SizeSquared(), Index), CandidateLess);
+				}
+			}
+		}
+	};
+
+	for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		if (Ring == 0)
+		{
+			AddCell(Center);
+		}
+		else
+		{
+			for (int32 X = -Ring; X <= Ring; X++)
+			{
+				AddCell(Center + FIntPoint(X, -Ring));
+				AddCell(Center + FIntPoint(X, Ring));
+			}
+			for (int32 Y = -Ring + 1; Y < Ring; Y++)
+			{
+				AddCell(Center + FIntPoint(-Ring, Y));
+				AddCell(Center + FIntPoint(Ring, Y));
+			}
+		}
+
+		// characters in outer rings are at least Ring cells away, anything closer can be visited
+		const float SafeDistSq = Ring < MaxRing ? FMath::Square(Ring * CellSize) : MAX_FLT;
+		while (Pending.Num() > 0 && Pending.HeapTop().Key <= SafeDistSq)
+		{
+			FCandidate Candidate;
+			Pending.HeapPop(Candidate, CandidateLess, false);
+			if (!Visitor(Entries[Candidate.Value].Pawn))
+			{
+				return;
+			}
+		}
+	}
+}
+
+void UShooterEnemyIndex::GetNearestEnemies(AController* Querier, const FVector& Location, int32 MaxCount, TArray<AShooterCharacter*>& OutEnemies)
+{
+	OutEnemies.Reset();
+	if (MaxCount <= 0)
+	{
+		return;
+	}
+
+	ForEachEnemyByDistance(Querier, Location, [&](AShooterCharacter* Enemy)
+	{
+		OutEnemies.Add(Enemy);
+		return OutEnemies.Num() < MaxCount;
+	});
+}
@@ -0,0 +1,243 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Bots/ShooterNavQueryBatcher.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "AIController.h"
+
+static int32 ShooterNavQueryBatcher = 1;
+FAutoConsoleVariableRef CVarShooterNavQueryBatcher(
+	TEXT("p.ShooterNavQueryBatcher"),
+	ShooterNavQueryBatcher,
+	TEXT("Bots queue their navigation point queries in a per frame batch instead of running them synchronously.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static int32 ShooterNavQueryBudget = 16;
+FAutoConsoleVariableRef CVarShooterNavQueryBudget(
+	TEXT("p.ShooterNavQueryBudget"),
+	ShooterNavQueryBudget,
+	TEXT("Maximum bot navigation point queries run per frame, the others wait for next frames."),
+	ECVF_Default);
+
+static float ShooterNavQueryCacheTime = 1.0f;
+FAutoConsoleVariableRef CVarShooterNavQueryCacheTime(
+	TEXT("p.ShooterNavQueryCacheTime"),
+	ShooterNavQueryCacheTime,
+	TEXT("Seconds a navigation point found near an enemy can be reused. 0 disables the cache."),
+	ECVF_Default);
+
+static float ShooterNavQueryCacheRadius = 150.0f;
+FAutoConsoleVariableRef CVarShooterNavQueryCacheRadius(
+	TEXT("p.ShooterNavQueryCacheRadius"),
+	ShooterNavQueryCacheRadius,
+	TEXT("Maximum distance between search origins for a cached navigation point to be reused."),
+	ECVF_Default);
+
+/** cached points kept per enemy */
+static const int32 MaxCachedPointsPerEnemy = 8;
+
+/** cached points needed near a search origin before they are served, the random pick spreads bots among them */
+static const int32 MinCachedPointsPerHit = 3;
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav point queries"), STAT_ShooterNavPointQueries, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav point cache hits"), STAT_ShooterNavPointCacheHits, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav point queued requests"), STAT_ShooterNavPointQueued, STATGROUP_ShooterAI);
+
+void UShooterNavQueryBatcher::Deinitialize()
+{
+	Requests.Empty();
+	Cache.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UShooterNavQueryBatcher::IsTickable() const
+{
+	return Requests.Num() > 0 || Cache.Num() > 0;
+}
+
+TStatId UShooterNavQueryBatcher::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterNavQueryBatcher, STATGROUP_Tickables);
+}
+
+UShooterNavQueryBatcher* UShooterNavQueryBatcher::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterNavQueryBatcher && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterNavQueryBatcher>() : nullptr;
+}
+
+bool UShooterNavQueryBatcher::GetNavQuery(const AController* Querier, ANavigationData*& OutNavData, FSharedConstNavQueryFilter& OutQueryFilter) const
+{
+	// same nav data and filter as UNavigationSystemV1::K2_GetRandomReachablePointInRadius, plus the AI's filter class
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	OutNavData = (NavSys && Querier) ? NavSys->GetNavDataForProps(Querier->GetNavAgentPropertiesRef()) : nullptr;
+	if (OutNavData == nullptr)
+	{
+		OutNavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	}
+	if (OutNavData == nullptr)
+	{
+		return false;
+	}
+
+	const AAIController* AIQuerier = Cast<AAIController>(Querier);
+	OutQueryFilter = UNavigationQueryFilter::GetQueryFilter(*OutNavData, Querier, AIQuerier ? AIQuerier->GetDefaultNavigationFilterClass() : nullptr);
+	return true;
+}
+
+bool UShooterNavQueryBatcher::PickCachedPoint(const FObjectKey& Enemy, const FVector& SearchOrigin, const ANavigationData* NavData, const FNavigationQueryFilter* QueryFilter, FVector& OutPoint) const
+{
+	const TArray<FCachedPoint>* CachedPoints = Cache.Find(Enemy);
+	if (!CachedPoints)
+	{
+		return false;
+	}
+
+	const float MinTime = GetWorld()->GetTimeSeconds() - ShooterNavQueryCacheTime;
+	const float MaxDistSq = FMath::Square(ShooterNavQueryCacheRadius);
+
+	const FCachedPoint* Candidates[MaxCachedPointsPerEnemy];
+	int32 NumCandidates = 0;
+	for (const FCachedPoint& CachedPoint : *CachedPoints)
+	{
+		if (CachedPoint.Time >= MinTime && CachedPoint.NavData == NavData && CachedPoint.QueryFilter == QueryFilter &&
+			FVector::DistSquared(CachedPoint.SearchOrigin, SearchOrigin) <= MaxDistSq && NumCandidates < MaxCachedPointsPerEnemy)
+		{
+			Candidates[NumCandidates++] = &CachedPoint;
+		}
+	}
+
+	// too few to spread bots, another query adds one
+	if (NumCandidates < MinCachedPointsPerHit)
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_ShooterNavPointCacheHits);
+	OutPoint = Candidates[FMath::RandHelper(NumCandidates)]->Point;
+	return true;
+}
+
+bool UShooterNavQueryBatcher::FindCachedPoint(const AController* Querier, const AActor* Enemy, const FVector& SearchOrigin, FVector& OutPoint) const
+{
+	ANavigationData* NavData = nullptr;
+	FSharedConstNavQueryFilter QueryFilter;
+	if (!Enemy || !GetNavQuery(Querier, NavData, QueryFilter))
+	{
+		return false;
+	}
+
+	return PickCachedPoint(FObjectKey(Enemy), SearchOrigin, NavData, QueryFilter.Get(), OutPoint);
+}
+
+uint32 UShooterNavQueryBatcher::RequestPoint(const AController* Querier, const AActor* Enemy, const FVector& SearchOrigin, float SearchRadius, FShooterNavPointCallback&& OnComplete)
+{
+	if (++NextRequestId == 0)
+	{
+		NextRequestId = 1;
+	}
+
+	FRequest& Request = Requests.AddDefaulted_GetRef();
+	Request.Id = NextRequestId;
+	Request.Enemy = FObjectKey(Enemy);
+	Request.SearchOrigin = SearchOrigin;
+	Request.SearchRadius = SearchRadius;
+	Request.OnComplete = MoveTemp(OnComplete);
+
+	ANavigationData* NavData = nullptr;
+	if (GetNavQuery(Querier, NavData, Request.QueryFilter))
+	{
+		Request.NavData = NavData;
+	}
+
+	return Request.Id;
+}
+
+void UShooterNavQueryBatcher::CancelRequest(uint32 RequestId)
+{
+	const int32 Index = Requests.IndexOfByPredicate([RequestId](const FRequest& Request) { return Request.Id == RequestId; });
+	if (Index != INDEX_NONE)
+	{
+		Requests.RemoveAt(Index, 1, false);
+	}
+}
+
+void UShooterNavQueryBatcher::AddCachedPoint(const FObjectKey& Enemy, const FVector& SearchOrigin, const FVector& Point, const ANavigationData* NavData, const FNavigationQueryFilter* QueryFilter)
+{
+	if (ShooterNavQueryCacheTime <= 0.0f)
+	{
+		return;
+	}
+
+	TArray<FCachedPoint>& CachedPoints = Cache.FindOrAdd(Enemy);
+	if (CachedPoints.Num() >= MaxCachedPointsPerEnemy)
+	{
+		CachedPoints.RemoveAt(0, 1, false);
+	}
+	CachedPoints.Add({ SearchOrigin, Point, GetWorld()->GetTimeSeconds(), NavData, QueryFilter });
+}
+
+void UShooterNavQueryBatcher::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// drop expired results
+	for (auto It = Cache.CreateIterator(); It; ++It)
+	{
+		It.Value().RemoveAll([Now](const FCachedPoint& CachedPoint) { return Now - CachedPoint.Time > ShooterNavQueryCacheTime; });
+		if (It.Value().Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (Requests.Num() == 0)
+	{
+		return;
+	}
+
+	// oldest requests first
+	const int32 NumToRun = FMath::Min(FMath::Max(ShooterNavQueryBudget, 1), Requests.Num());
+	TArray<FRequest> Batch;
+	Batch.Reserve(NumToRun);
+	for (int32 i = 0; i < NumToRun; i++)
+	{
+		Batch.Add(MoveTemp(Requests[i]));
+	}
+	Requests.RemoveAt(0, NumToRun, false);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	for (FRequest& Request : Batch)
+	{
+		// like K2_GetRandomReachablePointInRadius, a failed query leaves the search origin
+		FVector Point = Request.SearchOrigin;
+		bool bFound = false;
+
+		ANavigationData* NavData = Request.NavData.Get();
+		if (PickCachedPoint(Request.Enemy, Request.SearchOrigin, NavData, Request.QueryFilter.Get(), Point))
+		{
+			bFound = true;
+		}
+		else if (NavSys && NavData)
+		{
+			INC_DWORD_STAT(STAT_ShooterNavPointQueries);
+
+			FNavLocation NavLocation(Request.SearchOrigin);
+			bFound = NavSys->GetRandomReachablePointInRadius(Request.SearchOrigin, Request.SearchRadius, NavLocation, NavData, Request.QueryFilter);
+			if (bFound)
+			{
+				Point = NavLocation.Location;
+				AddCachedPoint(Request.Enemy, Request.SearchOrigin, Point, NavData, Request.QueryFilter.Get());
+			}
+		}
+
+		Request.OnComplete(Request.Id, bFound, Point);
+	}
+
+	SET_DWORD_STAT(STAT_ShooterNavPointQueued, Requests.Num());
+}
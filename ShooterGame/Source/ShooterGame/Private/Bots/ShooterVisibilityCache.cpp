@@ -0,0 +1,232 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Bots/ShooterVisibilityCache.h"
+
+static int32 ShooterVisibilityCache = 1;
+FAutoConsoleVariableRef CVarShooterVisibilityCache(
+	TEXT("p.ShooterVisibilityCache"),
+	ShooterVisibilityCache,
+	TEXT("Bots share cached, async line of sight traces instead of tracing on every check.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static int32 ShooterVisibilityTraceBudget = 32;
+FAutoConsoleVariableRef CVarShooterVisibilityTraceBudget(
+	TEXT("p.ShooterVisibilityTraceBudget"),
+	ShooterVisibilityTraceBudget,
+	TEXT("Maximum bot line of sight traces started per frame, the others wait for next frames."),
+	ECVF_Default);
+
+static float ShooterVisibilityMaxAge = 0.2f;
+FAutoConsoleVariableRef CVarShooterVisibilityMaxAge(
+	TEXT("p.ShooterVisibilityMaxAge"),
+	ShooterVisibilityMaxAge,
+	TEXT("Age in seconds after which a queried line of sight result is traced again.\n")
+	TEXT("Queued refreshes not queried again within this age are dropped."),
+	ECVF_Default);
+
+/** pairs not queried for this long are forgotten */
+static const float VisibilityEntryLifetime = 2.0f;
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility queries"), STAT_ShooterVisibilityQueries, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility fresh hits"), STAT_ShooterVisibilityFreshHits, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility traces started"), STAT_ShooterVisibilityTraces, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility sync traces"), STAT_ShooterVisibilitySyncTraces, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility dropped requests"), STAT_ShooterVisibilityDropped, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Visibility queued traces"), STAT_ShooterVisibilityQueued, STATGROUP_ShooterAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Visibility cached pairs"), STAT_ShooterVisibilityEntries, STATGROUP_ShooterAI);
+
+void UShooterVisibilityCache::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UShooterVisibilityCache::OnTraceCompleted);
+}
+
+void UShooterVisibilityCache::Deinitialize()
+{
+	TraceDelegate.Unbind();
+	Entries.Empty();
+	Requests.Empty();
+	PriorityRequests.Empty();
+	PendingTraces.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UShooterVisibilityCache::IsTickable() const
+{
+	return Entries.Num() > 0;
+}
+
+TStatId UShooterVisibilityCache::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterVisibilityCache, STATGROUP_Tickables);
+}
+
+UShooterVisibilityCache* UShooterVisibilityCache::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterVisibilityCache && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterVisibilityCache>() : nullptr;
+}
+
+void UShooterVisibilityCache::GetTraceParams(APawn* Viewer, AActor* Target, FVector& OutStart, FVector& OutEnd, FCollisionQueryParams& OutParams)
+{
+	OutParams = FCollisionQueryParams(SCENE_QUERY_STAT(AIWeaponLosTrace), true, Viewer);
+	OutStart = Viewer->GetActorLocation();
+	OutStart.Z += Viewer->BaseEyeHeight;
+	OutEnd = Target->GetActorLocation();
+}
+
+bool UShooterVisibilityCache::GetHitActor(APawn* Viewer, AActor* Target, AActor*& OutHitActor, bool bPriority)
+{
+	OutHitActor = nullptr;
+	if (!Viewer || !Target)
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_ShooterVisibilityQueries);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const FPairKey Key(FObjectKey(Viewer), FObjectKey(Target));
+
+	FEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		Entry = &Entries.Add(Key);
+		Entry->Viewer = Viewer;
+		Entry->Target = Target;
+		Entry->ResultTime = -1.0f;
+		Entry->RefreshState = ERefreshState::None;
+	}
+	Entry->QueryTime = Now;
+
+	if (Entry->ResultTime < 0.0f)
+	{
+		// no result to fall back on: reading it as not visible would make target selection go through every candidate
+		FCollisionQueryParams TraceParams;
+		FVector StartLocation, EndLocation;
+		GetTraceParams(Viewer, Target, StartLocation, EndLocation, TraceParams);
+
+		FHitResult Hit(ForceInit);
+		GetWorld()->LineTraceSingleByChannel(Hit, StartLocation, EndLocation, COLLISION_WEAPON, TraceParams);
+		INC_DWORD_STAT(STAT_ShooterVisibilitySyncTraces);
+
+		Entry->HitActor = Hit.bBlockingHit ? Hit.GetActor() : nullptr;
+		Entry->ResultTime = Now;
+	}
+	else if (Now - Entry->ResultTime <= ShooterVisibilityMaxAge)
+	{
+		INC_DWORD_STAT(STAT_ShooterVisibilityFreshHits);
+	}
+	else if (Entry->RefreshState == ERefreshState::None)
+	{
+		Entry->RefreshState = bPriority ? ERefreshState::PriorityQueued : ERefreshState::Queued;
+		(bPriority ? PriorityRequests : Requests).Add(Key);
+	}
+	else if (bPriority && Entry->RefreshState == ERefreshState::Queued)
+	{
+		// its entry in Requests is skipped
+		Entry->RefreshState = ERefreshState::PriorityQueued;
+		PriorityRequests.Add(Key);
+	}
+
+	OutHitActor = Entry->HitActor.Get();
+	return true;
+}
+
+void UShooterVisibilityCache::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// forget pairs nobody asks about anymore
+	if (Now - LastEvictionTime >= 1.0f)
+	{
+		LastEvictionTime = Now;
+		for (auto It = Entries.CreateIterator(); It; ++It)
+		{
+			const FEntry& Entry = It.Value();
+			if (Entry.RefreshState != ERefreshState::InFlight && (Now - Entry.QueryTime > VisibilityEntryLifetime || !Entry.Viewer.IsValid() || !Entry.Target.IsValid()))
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	StartTraces();
+
+	SET_DWORD_STAT(STAT_ShooterVisibilityQueued, Requests.Num() + PriorityRequests.Num());
+	SET_DWORD_STAT(STAT_ShooterVisibilityEntries, Entries.Num());
+}
+
+void UShooterVisibilityCache::StartTraces()
+{
+	const int32 Budget = FMath::Max(ShooterVisibilityTraceBudget, 1);
+
+	int32 NumTraces = StartTraces(PriorityRequests, ERefreshState::PriorityQueued, Budget);
+	NumTraces += StartTraces(Requests, ERefreshState::Queued, Budget - NumTraces);
+
+	INC_DWORD_STAT_BY(STAT_ShooterVisibilityTraces, NumTraces);
+}
+
+int32 UShooterVisibilityCache::StartTraces(TArray<FPairKey>& Queue, ERefreshState QueuedState, int32 Budget)
+{
+	UWorld* World = GetWorld();
+	const float Now = World->GetTimeSeconds();
+
+	int32 NumRequests = 0;
+	int32 NumTraces = 0;
+	while (NumRequests < Queue.Num() && NumTraces < Budget)
+	{
+		const FPairKey& Key = Queue[NumRequests++];
+		FEntry* Entry = Entries.Find(Key);
+		if (!Entry || Entry->RefreshState != QueuedState)
+		{
+			// evicted, or moved to the priority queue
+			continue;
+		}
+
+		APawn* Viewer = Entry->Viewer.Get();
+		AActor* Target = Entry->Target.Get();
+		if (!Viewer || !Target || Now - Entry->QueryTime > ShooterVisibilityMaxAge)
+		{
+			// nobody is waiting for this one anymore, the next query queues it again
+			Entry->RefreshState = ERefreshState::None;
+			INC_DWORD_STAT(STAT_ShooterVisibilityDropped);
+			continue;
+		}
+
+		FCollisionQueryParams TraceParams;
+		FVector StartLocation, EndLocation;
+		GetTraceParams(Viewer, Target, StartLocation, EndLocation, TraceParams);
+
+		const uint32 TraceId = NextTraceId++;
+		PendingTraces.Add(TraceId, Key);
+		Entry->RefreshState = ERefreshState::InFlight;
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, StartLocation, EndLocation, COLLISION_WEAPON, TraceParams, FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, TraceId);
+		NumTraces++;
+	}
+
+	Queue.RemoveAt(0, NumRequests, false);
+	return NumTraces;
+}
+
+void UShooterVisibilityCache::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	FPairKey Key;
+	if (!PendingTraces.RemoveAndCopyValue(Data.UserData, Key))
+	{
+		return;
+	}
+
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry)
+	{
+		const FHitResult* Hit = Data.OutHits.Num() > 0 && Data.OutHits[0].bBlockingHit ? &Data.OutHits[0] : nullptr;
+		Entry->HitActor = Hit ? Hit->GetActor() : nullptr;
+		Entry->ResultTime = GetWorld()->GetTimeSeconds();
+		Entry->RefreshState = ERefreshState::None;
+	}
+}
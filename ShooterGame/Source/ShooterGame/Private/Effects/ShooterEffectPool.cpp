@@ -0,0 +1,254 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Effects/ShooterImpactEffect.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Components/DecalComponent.h"
+
+static int32 ShooterFXPool = 1;
+FAutoConsoleVariableRef CVarShooterFXPool(
+	TEXT("p.ShooterFXPool"),
+	ShooterFXPool,
+	TEXT("Reuse weapon impact effects, trails and decals instead of spawning new ones.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static int32 ShooterFXPoolParticles = 32;
+FAutoConsoleVariableRef CVarShooterFXPoolParticles(
+	TEXT("p.ShooterFXPoolParticles"),
+	ShooterFXPoolParticles,
+	TEXT("Maximum pooled particle components per particle system.\n")
+	TEXT("When all of them are playing, the least recently used one is restarted."),
+	ECVF_Default);
+
+static int32 ShooterFXPoolDecals = 64;
+FAutoConsoleVariableRef CVarShooterFXPoolDecals(
+	TEXT("p.ShooterFXPoolDecals"),
+	ShooterFXPoolDecals,
+	TEXT("Maximum pooled impact decals.\n")
+	TEXT("When all of them are visible, the least recently used one is moved."),
+	ECVF_Default);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impact actors spawned"), STAT_ShooterFXImpactActorsSpawned, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impact actor spawns avoided"), STAT_ShooterFXImpactActorsReused, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Particle components created"), STAT_ShooterFXParticlesCreated, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Particle spawns avoided"), STAT_ShooterFXParticlesReused, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Particle LRU restarts"), STAT_ShooterFXParticlesEvicted, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Decal components created"), STAT_ShooterFXDecalsCreated, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Decal spawns avoided"), STAT_ShooterFXDecalsReused, STATGROUP_ShooterFX);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Decal LRU moves"), STAT_ShooterFXDecalsEvicted, STATGROUP_ShooterFX);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled particle components"), STAT_ShooterFXPooledParticles, STATGROUP_ShooterFX);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled decal components"), STAT_ShooterFXPooledDecals, STATGROUP_ShooterFX);
+
+void UShooterEffectPool::Deinitialize()
+{
+	Particles.Empty();
+	Decals.Empty();
+	ImpactEffects.Empty();
+	PoolActor = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UShooterEffectPool::IsTickable() const
+{
+	// only decals expire, and there are none on dedicated servers
+	return Decals.Num() > 0;
+}
+
+TStatId UShooterEffectPool::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterEffectPool, STATGROUP_Tickables);
+}
+
+void UShooterEffectPool::Tick(float DeltaTime)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (FPooledDecal& Decal : Decals)
+	{
+		if (Decal.ExpireTime > 0.0 && Decal.ExpireTime <= Now && Decal.Component)
+		{
+			Decal.ExpireTime = 0.0;
+			Decal.Component->SetVisibility(false);
+			Decal.Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		}
+	}
+}
+
+UShooterEffectPool* UShooterEffectPool::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterFXPool && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld() && World->GetNetMode() != NM_DedicatedServer) ? World->GetSubsystem<UShooterEffectPool>() : nullptr;
+}
+
+AActor* UShooterEffectPool::GetPoolActor()
+{
+	if (!PoolActor)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.ObjectFlags |= RF_Transient;
+		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		PoolActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnInfo);
+		PoolActor->SetRootComponent(NewObject<USceneComponent>(PoolActor, TEXT("PoolRoot")));
+		PoolActor->GetRootComponent()->RegisterComponent();
+	}
+
+	return PoolActor;
+}
+
+void UShooterEffectPool::SpawnImpactEffect(TSubclassOf<AShooterImpactEffect> Template, const FHitResult& Hit, const FTransform& SpawnTransform)
+{
+	if (!Template)
+	{
+		return;
+	}
+
+	AShooterImpactEffect*& EffectActor = ImpactEffects.FindOrAdd(Template);
+	if (EffectActor && !EffectActor->IsPendingKill())
+	{
+		INC_DWORD_STAT(STAT_ShooterFXImpactActorsReused);
+		EffectActor->SetActorTransform(SpawnTransform);
+		EffectActor->SurfaceHit = Hit;
+		EffectActor->PlayEffect();
+		return;
+	}
+
+	// the first effect of a class is played by PostInitializeComponents, like non pooled ones
+	EffectActor = GetWorld()->SpawnActorDeferred<AShooterImpactEffect>(Template, SpawnTransform);
+	if (EffectActor)
+	{
+		INC_DWORD_STAT(STAT_ShooterFXImpactActorsSpawned);
+		EffectActor->SurfaceHit = Hit;
+		EffectActor->SetAutoDestroyWhenFinished(false);
+		UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+	}
+}
+
+UParticleSystemComponent* UShooterEffectPool::SpawnEmitter(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation)
+{
+	if (!Template)
+	{
+		return nullptr;
+	}
+
+	TArray<FPooledParticle>& Pool = Particles.FindOrAdd(Template);
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// a finished component, or the least recently used one if the pool is full
+	FPooledParticle* Entry = nullptr;
+	FPooledParticle* Oldest = nullptr;
+	for (FPooledParticle& Particle : Pool)
+	{
+		if (!Particle.Component || Particle.Component->IsPendingKill())
+		{
+			continue;
+		}
+		if (!Particle.Component->IsActive())
+		{
+			Entry = &Particle;
+			break;
+		}
+		if (!Oldest || Particle.LastUseTime < Oldest->LastUseTime)
+		{
+			Oldest = &Particle;
+		}
+	}
+
+	if (Entry)
+	{
+		INC_DWORD_STAT(STAT_ShooterFXParticlesReused);
+	}
+	else if (Oldest && Pool.Num() >= ShooterFXPoolParticles)
+	{
+		INC_DWORD_STAT(STAT_ShooterFXParticlesReused);
+		INC_DWORD_STAT(STAT_ShooterFXParticlesEvicted);
+		Entry = Oldest;
+	}
+	else
+	{
+		UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(GetPoolActor());
+		Component->bAutoDestroy = false;
+		Component->bAutoActivate = false;
+		Component->SetTemplate(Template);
+		Component->SetUsingAbsoluteLocation(true);
+		Component->SetUsingAbsoluteRotation(true);
+		Component->SetupAttachment(GetPoolActor()->GetRootComponent());
+		Component->RegisterComponent();
+
+		Entry = &Pool.AddDefaulted_GetRef();
+		Entry->Component = Component;
+		INC_DWORD_STAT(STAT_ShooterFXParticlesCreated);
+		INC_DWORD_STAT(STAT_ShooterFXPooledParticles);
+	}
+
+	Entry->LastUseTime = Now;
+	Entry->Component->SetWorldLocationAndRotation(Location, Rotation);
+	Entry->Component->ActivateSystem(true);
+	return Entry->Component;
+}
+
+UDecalComponent* UShooterEffectPool::SpawnDecal(UMaterialInterface* Material, const FVector& Size, USceneComponent* AttachTo, FName AttachBoneName, const FVector& Location, const FRotator& Rotation, float LifeSpan)
+{
+	if (!Material || !AttachTo)
+	{
+		return nullptr;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// an expired decal, or the least recently used one if the pool is full
+	FPooledDecal* Entry = nullptr;
+	FPooledDecal* Oldest = nullptr;
+	for (FPooledDecal& Decal : Decals)
+	{
+		if (!Decal.Component || Decal.Component->IsPendingKill())
+		{
+			continue;
+		}
+		if (Decal.ExpireTime <= 0.0)
+		{
+			Entry = &Decal;
+			break;
+		}
+		if (!Oldest || Decal.LastUseTime < Oldest->LastUseTime)
+		{
+			Oldest = &Decal;
+		}
+	}
+
+	if (Entry)
+	{
+		INC_DWORD_STAT(STAT_ShooterFXDecalsReused);
+	}
+	else if (Oldest && Decals.Num() >= ShooterFXPoolDecals)
+	{
+		INC_DWORD_STAT(STAT_ShooterFXDecalsReused);
+		INC_DWORD_STAT(STAT_ShooterFXDecalsEvicted);
+		Entry = Oldest;
+	}
+	else
+	{
+		UDecalComponent* Component = NewObject<UDecalComponent>(GetPoolActor());
+		Component->bAllowAnyoneToDestroyMe = true;
+		Component->RegisterComponent();
+
+		Entry = &Decals.AddDefaulted_GetRef();
+		Entry->Component = Component;
+		INC_DWORD_STAT(STAT_ShooterFXDecalsCreated);
+		INC_DWORD_STAT(STAT_ShooterFXPooledDecals);
+	}
+
+	UDecalComponent* Component = Entry->Component;
+	Component->SetDecalMaterial(Material);
+	Component->DecalSize = Size;
+	Component->AttachToComponent(AttachTo, FAttachmentTransformRules::KeepWorldTransform, AttachBoneName);
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->SetVisibility(true);
+	Component->MarkRenderStateDirty();
+
+	Entry->LastUseTime = Now;
+	Entry->ExpireTime = Now + FMath::Max(LifeSpan, KINDA_SMALL_NUMBER);
+	return Component;
+}
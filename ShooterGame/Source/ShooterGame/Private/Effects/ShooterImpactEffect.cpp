@@ -2,6 +2,7 @@
 
 #include "ShooterGame.h"
 #include "ShooterImpactEffect.h"
+#include "Effects/ShooterEffectPool.h"
 
 AShooterImpactEffect::AShooterImpactEffect(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -12,6 +13,13 @@ void AShooterImpactEffect::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	PlayEffect();
+}
+
+void AShooterImpactEffect::PlayEffect()
+{
+	UShooterEffectPool* EffectPool = UShooterEffectPool::Get(this);
+
 	UPhysicalMaterial* HitPhysMat = SurfaceHit.PhysMaterial.Get();
 	EPhysicalSurface HitSurfaceType = UPhysicalMaterial::DetermineSurfaceType(HitPhysMat);
 
@@ -19,7 +27,14 @@ void AShooterImpactEffect::PostInitializeComponents()
 	UParticleSystem* ImpactFX = GetImpactFX(HitSurfaceType);
 	if (ImpactFX)
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(this, ImpactFX, GetActorLocation(), GetActorRotation());
+		if (EffectPool)
+		{
+			EffectPool->SpawnEmitter(ImpactFX, GetActorLocation(), GetActorRotation());
+		}
+		else
+		{
+			UGameplayStatics::SpawnEmitterAtLocation(this, ImpactFX, GetActorLocation(), GetActorRotation());
+		}
 	}
 
 	// play sound
@@ -34,10 +49,19 @@ void AShooterImpactEffect::PostInitializeComponents()
 		FRotator RandomDecalRotation = SurfaceHit.ImpactNormal.Rotation();
 		RandomDecalRotation.Roll = FMath::FRandRange(-180.0f, 180.0f);
 
-		UGameplayStatics::SpawnDecalAttached(DefaultDecal.DecalMaterial, FVector(1.0f, DefaultDecal.DecalSize, DefaultDecal.DecalSize),
-			SurfaceHit.Component.Get(), SurfaceHit.BoneName,
-			SurfaceHit.ImpactPoint, RandomDecalRotation, EAttachLocation::KeepWorldPosition,
-			DefaultDecal.LifeSpan);
+		if (EffectPool)
+		{
+			EffectPool->SpawnDecal(DefaultDecal.DecalMaterial, FVector(1.0f, DefaultDecal.DecalSize, DefaultDecal.DecalSize),
+				SurfaceHit.Component.Get(), SurfaceHit.BoneName,
+				SurfaceHit.ImpactPoint, RandomDecalRotation, DefaultDecal.LifeSpan);
+		}
+		else
+		{
+			UGameplayStatics::SpawnDecalAttached(DefaultDecal.DecalMaterial, FVector(1.0f, DefaultDecal.DecalSize, DefaultDecal.DecalSize),
+				SurfaceHit.Component.Get(), SurfaceHit.BoneName,
+				SurfaceHit.ImpactPoint, RandomDecalRotation, EAttachLocation::KeepWorldPosition,
+				DefaultDecal.LifeSpan);
+		}
 	}
 }
 
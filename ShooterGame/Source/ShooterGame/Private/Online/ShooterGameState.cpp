@@ -2,6 +2,8 @@
 
 #include "ShooterGame.h"
 #include "Online/ShooterPlayerState.h"
+#include "Weapons/ShooterProjectile.h"
+#include "Weapons/ShooterProjectileSimulation.h"
 #include "ShooterGameInstance.h"
 #include "OnlineSubsystemUtils.h"
 #include "OnlineGameMatchesInterface.h"
@@ -27,6 +29,25 @@ void AShooterGameState::GetLifetimeReplicatedProps( TArray< FLifetimeProperty >
 	DOREPLIFETIME( AShooterGameState, TeamScores );
 }
 
+void AShooterGameState::MulticastSimulatedProjectileFired_Implementation(TSubclassOf<AShooterProjectile> ProjectileClass, FVector_NetQuantize Origin, FVector_NetQuantizeNormal ShootDir, uint16 ProjectileId, float ProjectileLife)
+{
+	// the server is already simulating it
+	UShooterProjectileSimulation* Simulation = UShooterProjectileSimulation::Get(this);
+	if (Simulation && GetLocalRole() < ROLE_Authority)
+	{
+		Simulation->SimulateProjectile(ProjectileClass, Origin, ShootDir, ProjectileId, ProjectileLife);
+	}
+}
+
+void AShooterGameState::MulticastSimulatedProjectileExploded_Implementation(TSubclassOf<AShooterProjectile> ProjectileClass, uint16 ProjectileId, FVector_NetQuantize ImpactPoint, FVector_NetQuantizeNormal ImpactNormal)
+{
+	UShooterProjectileSimulation* Simulation = UShooterProjectileSimulation::Get(this);
+	if (Simulation)
+	{
+		Simulation->ExplodeProjectile(ProjectileClass, ProjectileId, ImpactPoint, ImpactNormal);
+	}
+}
+
 void AShooterGameState::GetRankedMap(int32 TeamIndex, RankedPlayerMap& OutRankedMap) const
 {
 	OutRankedMap.Empty();
@@ -2,6 +2,7 @@
 
 #include "ShooterGame.h"
 #include "Pickups/ShooterPickup.h"
+#include "Pickups/ShooterPickupRegistry.h"
 #include "Particles/ParticleSystemComponent.h"
 
 AShooterPickup::AShooterPickup(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -38,6 +39,12 @@ void AShooterPickup::BeginPlay()
 	if (GameMode)
 	{
 		GameMode->LevelPickups.Add(this);
+
+		UShooterPickupRegistry* PickupRegistry = UShooterPickupRegistry::Get(this);
+		if (PickupRegistry)
+		{
+			PickupRegistry->RegisterPickup(this);
+		}
 	}
 }
 
@@ -96,6 +103,12 @@ void AShooterPickup::RespawnPickup()
 
 void AShooterPickup::OnPickedUp()
 {
+	UShooterPickupRegistry* PickupRegistry = UShooterPickupRegistry::Get(this);
+	if (PickupRegistry)
+	{
+		PickupRegistry->SetAvailable(this, false);
+	}
+
 	if (RespawningFX)
 	{
 		PickupPSC->SetTemplate(RespawningFX);
@@ -116,6 +129,12 @@ void AShooterPickup::OnPickedUp()
 
 void AShooterPickup::OnRespawned()
 {
+	UShooterPickupRegistry* PickupRegistry = UShooterPickupRegistry::Get(this);
+	if (PickupRegistry)
+	{
+		PickupRegistry->SetAvailable(this, true);
+	}
+
 	if (ActiveFX)
 	{
 		PickupPSC->SetTemplate(ActiveFX);
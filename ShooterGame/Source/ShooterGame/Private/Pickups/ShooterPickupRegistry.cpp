@@ -0,0 +1,253 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Pickups/ShooterPickupRegistry.h"
+#include "Pickups/ShooterPickup.h"
+#include "NavigationSystem.h"
+
+static int32 ShooterPickupRegistry = 1;
+FAutoConsoleVariableRef CVarShooterPickupRegistry(
+	TEXT("p.ShooterPickupRegistry"),
+	ShooterPickupRegistry,
+	TEXT("Bots find pickups through a per class spatial index of available pickups, instead of scanning all of them.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static int32 ShooterPickupPathCandidates = 4;
+FAutoConsoleVariableRef CVarShooterPickupPathCandidates(
+	TEXT("p.ShooterPickupPathCandidates"),
+	ShooterPickupPathCandidates,
+	TEXT("Nearest pickups, by straight line, whose navigation path cost is compared when ranking by path cost."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Pickup query"), STAT_ShooterPickupQuery, STATGROUP_ShooterAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pickup path cost queries"), STAT_ShooterPickupPathQueries, STATGROUP_ShooterAI);
+
+void UShooterPickupRegistry::Deinitialize()
+{
+	Trees.Empty();
+
+	Super::Deinitialize();
+}
+
+UShooterPickupRegistry* UShooterPickupRegistry::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterPickupRegistry && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterPickupRegistry>() : nullptr;
+}
+
+void UShooterPickupRegistry::RegisterPickup(AShooterPickup* Pickup)
+{
+	if (Pickup)
+	{
+		FPickupTree& Tree = Trees.FindOrAdd(Pickup->GetClass());
+		Tree.Pickups.AddUnique(Pickup);
+		Tree.bDirty = true;
+	}
+}
+
+void UShooterPickupRegistry::SetAvailable(AShooterPickup* Pickup, bool bAvailable)
+{
+	FPickupTree* Tree = Pickup ? Trees.Find(Pickup->GetClass()) : nullptr;
+	if (!Tree || Tree->bDirty)
+	{
+		// not registered, or availability will be read on rebuild
+		return;
+	}
+
+	const int32* NodeIndex = Tree->NodeIndices.Find(Pickup);
+	if (!NodeIndex || Tree->Nodes[*NodeIndex].bAvailable == bAvailable)
+	{
+		return;
+	}
+
+	Tree->Nodes[*NodeIndex].bAvailable = bAvailable;
+
+	const int32 Delta = bAvailable ? 1 : -1;
+	for (int32 Index = *NodeIndex; Index != INDEX_NONE; Index = Tree->Nodes[Index].Parent)
+	{
+		Tree->Nodes[Index].NumAvailable += Delta;
+	}
+}
+
+void UShooterPickupRegistry::BuildTree(FPickupTree& Tree)
+{
+	Tree.bDirty = false;
+	Tree.Nodes.Reset();
+	Tree.NodeIndices.Reset();
+
+	Tree.Pickups.RemoveAll([](const TWeakObjectPtr<AShooterPickup>& Pickup) { return !Pickup.IsValid(); });
+	for (const TWeakObjectPtr<AShooterPickup>& Pickup : Tree.Pickups)
+	{
+		FNode& Node = Tree.Nodes.AddDefaulted_GetRef();
+		Node.Pickup = Pickup;
+		Node.Location = Pickup->GetActorLocation();
+		Node.bAvailable = Pickup->IsActive();
+	}
+
+	if (Tree.Nodes.Num() > 0)
+	{
+		BuildNode(Tree, 0, Tree.Nodes.Num(), INDEX_NONE);
+	}
+
+	for (int32 i = 0; i < Tree.Nodes.Num(); i++)
+	{
+		Tree.NodeIndices.Add(Tree.Nodes[i].Pickup.Get(), i);
+	}
+}
+
+int32 UShooterPickupRegistry::BuildNode(FPickupTree& Tree, int32 Begin, int32 End, int32 Parent)
+{
+	// split along the largest extent
+	FBox Bounds(ForceInit);
+	for (int32 i = Begin; i < End; i++)
+	{
+		Bounds += Tree.Nodes[i].Location;
+	}
+
+	const FVector Extent = Bounds.GetExtent();
+	const int32 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+
+	Sort(Tree.Nodes.GetData() + Begin, End - Begin, [Axis](const FNode& A, const FNode& B) { return A.Location[Axis] < B.Location[Axis]; });
+
+	const int32 Index = (Begin + End) / 2;
+	int32 NumAvailable = Tree.Nodes[Index].bAvailable ? 1 : 0;
+
+	if (Begin < Index)
+	{
+		NumAvailable += Tree.Nodes[BuildNode(Tree, Begin, Index, Index)].NumAvailable;
+	}
+	if (Index + 1 < End)
+	{
+		NumAvailable += Tree.Nodes[BuildNode(Tree, Index + 1, End, Index)].NumAvailable;
+	}
+
+	FNode& Node = Tree.Nodes[Index];
+	Node.Axis = Axis;
+	Node.Parent = Parent;
+	Node.Begin = Begin;
+	Node.End = End;
+	Node.NumAvailable = NumAvailable;
+	return Index;
+}
+
+void UShooterPickupRegistry::FindNearest(const FPickupTree& Tree, const FVector& Location, int32 MaxCount, TArray<TPair<float, int32>, TInlineAllocator<8>>& OutNearest) const
+{
+	OutNearest.Reset();
+	if (Tree.Nodes.Num() > 0 && MaxCount > 0)
+	{
+		FindNearestInNode(Tree, Tree.Nodes.Num() / 2, Location, MaxCount, OutNearest);
+	}
+}
+
+void UShooterPickupRegistry::FindNearestInNode(const FPickupTree& Tree, int32 NodeIndex, const FVector& Location, int32 MaxCount, TArray<TPair<float, int32>, TInlineAllocator<8>>& OutNearest) const
+{
+	const FNode& Node = Tree.Nodes[NodeIndex];
+	if (Node.NumAvailable == 0)
+	{
+		return;
+	}
+
+	if (Node.bAvailable && Node.Pickup.IsValid())
+	{
+		const float DistSq = FVector::DistSquared(Node.Location, Location);
+		if (OutNearest.Num() < MaxCount || DistSq < OutNearest.Last().Key)
+		{
+			int32 InsertIndex = OutNearest.Num();
+			while (InsertIndex > 0 && OutNearest[InsertIndex - 1].Key > DistSq)
+			{
+				InsertIndex--;
+			}
+
+			OutNearest.Insert(TPair<float, int32>(DistSq, NodeIndex), InsertIndex);
+			if (OutNearest.Num() > MaxCount)
+			{
+				OutNearest.Pop(false);
+			}
+		}
+	}
+
+	const int32 LeftIndex = Node.Begin < NodeIndex ? (Node.Begin + NodeIndex) / 2 : INDEX_NONE;
+	const int32 RightIndex = NodeIndex + 1 < Node.End ? (NodeIndex + 1 + Node.End) / 2 : INDEX_NONE;
+
+	// near side first, far side only if it can still hold something closer
+	const float PlaneDist = Location[Node.Axis] - Node.Location[Node.Axis];
+	const int32 NearIndex = PlaneDist < 0.0f ? LeftIndex : RightIndex;
+	const int32 FarIndex = PlaneDist < 0.0f ? RightIndex : LeftIndex;
+
+	if (NearIndex != INDEX_NONE)
+	{
+		FindNearestInNode(Tree, NearIndex, Location, MaxCount, OutNearest);
+	}
+	if (FarIndex != INDEX_NONE && (OutNearest.Num() < MaxCount || FMath::Square(PlaneDist) < OutNearest.Last().Key))
+	{
+		FindNearestInNode(Tree, FarIndex, Location, MaxCount, OutNearest);
+	}
+}
+
+AShooterPickup* UShooterPickupRegistry::FindNearestPickup(AShooterCharacter* Pawn, const FVector& Location, TFunctionRef<bool(AShooterPickup*)> TypeFilter, bool bUsePathCost)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterPickupQuery);
+
+	const int32 NumCandidates = bUsePathCost ? FMath::Max(ShooterPickupPathCandidates, 1) : 1;
+	TArray<TPair<float, AShooterPickup*>, TInlineAllocator<8>> Candidates;
+	TArray<TPair<float, int32>, TInlineAllocator<8>> Nearest;
+
+	for (TPair<UClass*, FPickupTree>& It : Trees)
+	{
+		FPickupTree& Tree = It.Value;
+		if (Tree.bDirty)
+		{
+			BuildTree(Tree);
+		}
+
+		AShooterPickup* Sample = Tree.Nodes.Num() > 0 ? Tree.Nodes[0].Pickup.Get() : nullptr;
+		if (!Sample || !TypeFilter(Sample))
+		{
+			continue;
+		}
+
+		FindNearest(Tree, Location, NumCandidates, Nearest);
+
+		// pickups of a class only differ by availability, the nearest one answers for all
+		AShooterPickup* NearestPickup = Nearest.Num() > 0 ? Tree.Nodes[Nearest[0].Value].Pickup.Get() : nullptr;
+		if (!NearestPickup || !NearestPickup->CanBePickedUp(Pawn))
+		{
+			continue;
+		}
+
+		for (const TPair<float, int32>& Candidate : Nearest)
+		{
+			Candidates.Add(TPair<float, AShooterPickup*>(Candidate.Key, Tree.Nodes[Candidate.Value].Pickup.Get()));
+		}
+	}
+
+	if (Candidates.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	Candidates.Sort([](const TPair<float, AShooterPickup*>& A, const TPair<float, AShooterPickup*>& B) { return A.Key < B.Key; });
+
+	UNavigationSystemV1* NavSys = bUsePathCost ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()) : nullptr;
+	if (!NavSys)
+	{
+		return Candidates[0].Value;
+	}
+
+	AShooterPickup* BestPickup = nullptr;
+	float BestCost = MAX_FLT;
+	for (int32 i = 0; i < FMath::Min(Candidates.Num(), NumCandidates); i++)
+	{
+		float PathCost = 0.0f;
+		INC_DWORD_STAT(STAT_ShooterPickupPathQueries);
+		if (NavSys->GetPathCost(Location, Candidates[i].Value->GetActorLocation(), PathCost) == ENavigationQueryResult::Success && PathCost < BestCost)
+		{
+			BestCost = PathCost;
+			BestPickup = Candidates[i].Value;
+		}
+	}
+
+	// nothing reachable on the navmesh, fall back to straight line
+	return BestPickup ? BestPickup : Candidates[0].Value;
+}
@@ -27,6 +27,16 @@ FAutoConsoleVariableRef CVarNetEnablePauseRelevancy(
 	TEXT("0: Disable, 1: Enable"),
 	ECVF_Cheat);
 
+static int32 ShooterJetpackEnergySegments = 1;
+FAutoConsoleVariableRef CVarShooterJetpackEnergySegments(
+	TEXT("p.ShooterJetpackEnergySegments"),
+	ShooterJetpackEnergySegments,
+	TEXT("Replicate jetpack energy only when its rate changes.\n")
+	TEXT("0: Disable, replicates it every tick (for bandwidth comparison), 1: Enable"),
+	ECVF_Default);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Jetpack energy segment updates"), STAT_ShooterJetpackSegmentUpdates, STATGROUP_ShooterMovement);
+
 FOnShooterCharacterEquipWeapon AShooterCharacter::NotifyEquipWeapon;
 FOnShooterCharacterUnEquipWeapon AShooterCharacter::NotifyUnEquipWeapon;
 
@@ -68,12 +78,17 @@ AShooterCharacter::AShooterCharacter(const FObjectInitializer& ObjectInitializer
 	BaseTurnRate = 45.f;
 	BaseLookUpRate = 45.f;
 
+	ShooterCharacterMovement = Cast<UShooterCharacterMovement>(GetCharacterMovement());
+
 }
 
 void AShooterCharacter::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	/*Ability code runs many times per tick, and again for every replayed move: it uses this typed pointer instead of casting*/
+	ShooterCharacterMovement = Cast<UShooterCharacterMovement>(GetCharacterMovement());
+
 	if (GetLocalRole() == ROLE_Authority)
 	{
 		Health = GetMaxHealth();
@@ -1203,7 +1218,8 @@ void AShooterCharacter::GetLifetimeReplicatedProps(TArray< FLifetimeProperty > &
 	DOREPLIFETIME(AShooterCharacter, CurrentWeapon);
 	DOREPLIFETIME(AShooterCharacter, Health);
 
-	DOREPLIFETIME_CONDITION(AShooterCharacter, JetpackEnergy, COND_OwnerOnly);
+	// only to local owner: energy is extrapolated from the last rate change
+	DOREPLIFETIME_CONDITION(AShooterCharacter, JetpackEnergySegment, COND_OwnerOnly);
 }
 
 bool AShooterCharacter::IsReplicationPausedForConnection(const FNetViewer& ConnectionOwnerNetViewer)
@@ -1345,58 +1361,58 @@ void AShooterCharacter::BuildPauseReplicationCheckPoints(TArray<FVector>& Releva
 void AShooterCharacter::OnRequestTeleport() {
 
 	AShooterPlayerController* MyPC = Cast<AShooterPlayerController>(Controller);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!MyPC || !CharMov)
 		return;
 
 	if (MyPC->IsGameInputAllowed() && CharMov->CanTeleport())
-		CharMov->SetTriggeringTeleport(true);
+		CharMov->SetTriggering(EShooterMovementAbility::Teleport, true);
 
 }
 
 void AShooterCharacter::OnRequestWallJump()
 {
 	AShooterPlayerController* MyPC = Cast<AShooterPlayerController>(Controller);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!MyPC || !CharMov)
 		return;
 	if (MyPC->IsGameInputAllowed() && CharMov->CanWallJump())
-		CharMov->SetTriggeringWallJump(true);
+		CharMov->SetTriggering(EShooterMovementAbility::WallJump, true);
 }
 
 void AShooterCharacter::OnRequestStartJetpackSprint()
 {
 	AShooterPlayerController* MyPC = Cast<AShooterPlayerController>(Controller);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!MyPC || !CharMov)
 		return;
 
 
 	if (MyPC->IsGameInputAllowed() && CharMov->CanJetpackSprint())
-		CharMov->SetTriggeringJetpackSprint(true);
+		CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, true);
 
 }
 
 void AShooterCharacter::OnRequestStopJetpackSprint()
 {
 	AShooterPlayerController* MyPC = Cast<AShooterPlayerController>(Controller);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!MyPC || !CharMov)
 		return;
 
 	if (MyPC->IsGameInputAllowed())
-		CharMov->SetTriggeringJetpackSprint(false);
+		CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, false);
 
 }
 
 void AShooterCharacter::OnRequestWallRunStart()
 {
 	AShooterPlayerController* MyPC = Cast<AShooterPlayerController>(Controller);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!MyPC || !CharMov || !MyPC->IsGameInputAllowed())
 		return;
@@ -1404,11 +1420,11 @@ void AShooterCharacter::OnRequestWallRunStart()
 	/*This can trigger both WallRun and WallRunJump actions*/
 
 	if (CharMov->CanWallRunJump()) {
-		CharMov->SetTriggeringWallRunJump(true);
+		CharMov->SetTriggering(EShooterMovementAbility::WallRunJump, true);
 	}
 	else {
 		if (CharMov->CanWallRun(false))
-			CharMov->SetTriggeringWallRun(true);
+			CharMov->SetTriggering(EShooterMovementAbility::WallRun, true);
 	}
 
 }
@@ -1416,14 +1432,14 @@ void AShooterCharacter::OnRequestWallRunStart()
 void AShooterCharacter::OnRequestWallRunStop()
 {
 	AShooterPlayerController* MyPC = Cast<AShooterPlayerController>(Controller);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!MyPC || !CharMov)
 		return;
 
 	/*Before toggling WallRunChangeState I want to be sure that WallRun isn't alredy turned off*/
 	if (MyPC->IsGameInputAllowed() && CharMov->CanStopWallRun()) {
-		CharMov->SetTriggeringWallRun(true);
+		CharMov->SetTriggering(EShooterMovementAbility::WallRun, true);
 	}
 		
 }
@@ -1432,7 +1448,7 @@ void AShooterCharacter::OnRequestWallRunStop()
 
 void AShooterCharacter::Teleport() {
 
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!CharMov || !CharMov->CanTeleport())
 		return;
@@ -1444,13 +1460,18 @@ void AShooterCharacter::Teleport() {
 	* according to player's view direction. 
 	* Teleport movement is NOT limited on the z-plane.
 	*/
-	TeleportTo(OldPosition + Controller->GetControlRotation().Vector() * CharMov->TeleportDistance, GetActorRotation());
+	FVector Destination;
+	if (!Controller || !CharMov->ResolveTeleportDestination(OldPosition + Controller->GetControlRotation().Vector() * CharMov->TeleportDistance, Destination))
+		return;
+
+	/*The destination has already been checked, so encroachment checks are skipped*/
+	TeleportTo(Destination, GetActorRotation(), false, true);
 	
 }
 
 void AShooterCharacter::WallJump()
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 
 	if (!CharMov || !CharMov->CanWallJump())
 		return;
@@ -1464,38 +1485,76 @@ void AShooterCharacter::WallJump()
 
 void AShooterCharacter::JetpackTick(float DeltaTime)
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return;
 
-	if (CharMov->GetTriggeringJetpackSprint()) {
+	if (CharMov->IsTriggering(EShooterMovementAbility::JetpackSprint)) {
 		if (0 < GetJetpackEnergy())
 			JetpackSprint(DeltaTime);
 		else
-			CharMov->SetTriggeringJetpackSprint(false);
+			CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, false);
 	} 
 	else 
 		if (GetJetpackEnergy() < GetMaxJetpackEnergy())
 			JetpackRecharge(DeltaTime);
 
+	if (GetLocalRole() == ROLE_Authority)
+		UpdateJetpackEnergySegment();
+}
+
+void AShooterCharacter::UpdateJetpackEnergySegment()
+{
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
+	AGameStateBase* GameState = GetWorld() ? GetWorld()->GetGameState() : nullptr;
+	if (!CharMov || !GameState)
+		return;
+
+	/*Rate the energy will follow from now on, until next transition*/
+	float Rate = 0.0f;
+	if (CharMov->IsTriggering(EShooterMovementAbility::JetpackSprint) && 0 < GetJetpackEnergy())
+		Rate = -(float)CharMov->JetpackEPS;
+	else if (!CharMov->IsTriggering(EShooterMovementAbility::JetpackSprint) && GetJetpackEnergy() < GetMaxJetpackEnergy())
+		Rate = (float)CharMov->JetpackRechargeEPS;
+
+	if (ShooterJetpackEnergySegments && Rate == JetpackEnergySegment.Rate)
+		return;
+
+	JetpackEnergySegment.Value = GetJetpackEnergy();
+	JetpackEnergySegment.Rate = Rate;
+	JetpackEnergySegment.ServerTime = GameState->GetServerWorldTimeSeconds();
+	INC_DWORD_STAT(STAT_ShooterJetpackSegmentUpdates);
+}
+
+void AShooterCharacter::OnRep_JetpackEnergySegment()
+{
+	AGameStateBase* GameState = GetWorld() ? GetWorld()->GetGameState() : nullptr;
+	const float ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : JetpackEnergySegment.ServerTime;
+
+	SetJetpackEnergy(JetpackEnergySegment.Evaluate(ServerTime, GetMaxJetpackEnergy()));
 }
 
 void AShooterCharacter::JetpackSprint(float DeltaTime) {
 	
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	
 	if (!CharMov)
 		return;
 
 	float NewEnergy = FMath::Max(0.0f, GetJetpackEnergy() - (float)(CharMov->JetpackEPS * DeltaTime));
 	SetJetpackEnergy(NewEnergy);
-	CharMov->AddForce(FVector::UpVector * CharMov->JetpackUpwardAcceleration * CharMov->Mass);
+
+	/*A fixed substep pushes the same velocity change whatever the move duration, a force is integrated over the whole move*/
+	if (CharMov->IsUsingFixedAbilitySubsteps())
+		CharMov->AddImpulse(FVector::UpVector * CharMov->JetpackUpwardAcceleration * DeltaTime, true);
+	else
+		CharMov->AddForce(FVector::UpVector * CharMov->JetpackUpwardAcceleration * CharMov->Mass);
 		
 }
 
 void AShooterCharacter::JetpackRecharge(float DeltaTime)
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return;
 
@@ -1505,23 +1564,14 @@ void AShooterCharacter::JetpackRecharge(float DeltaTime)
 
 void AShooterCharacter::WallRunTick(float DeltaTime)
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return;
 
 	
 
-	if (CharMov->IsWallRunning()) {
-		
-		double TimeNow = GetWorld()->TimeSeconds;
-
-		/*I check whether WallRun time limit is over and if another wallgrip point is available*/
-		if (TimeNow < CharMov->GetWallRunMaxEndingTime() && WallRunCalculateNewWallGripPoint(DeltaTime))
-			WallRunMoveToNewPosition();
-		else
-			WallRunChangeState();
-	}
-	else {
+	/*WallRunning movement itself is performed by UShooterCharacterMovement::PhysCustom*/
+	if (!CharMov->IsWallRunning()) {
 		/*Here I check when the flow of WallRunning finally ends (usually touching the ground).
 		* This is necessary in order to prevent a wall normal direction check when a new WallRun flow will be started */
 		if (CharMov->GetWallRunFlowing() && !CharMov->IsFalling())
@@ -1533,7 +1583,7 @@ void AShooterCharacter::WallRunTick(float DeltaTime)
 
 void AShooterCharacter::WallRunChangeState() {
 
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return;
 
@@ -1550,8 +1600,8 @@ void AShooterCharacter::WallRunChangeState() {
 		CharMov->SetMovementMode(MOVE_WallRunning);
 		CharMov->SetWallRunFlowing(true);
 		
+		/*The player will be moved towards the wall by the first WallRunning physics step*/
 		WallRunComputeMovementDirection();
-		WallRunMoveToNewPosition();
 	}
 	else {
 		CharMov->SetWallRunMaxJumpTime(TimeNow + CharMov->WallRunMaxJumpDelay);
@@ -1567,7 +1617,7 @@ void AShooterCharacter::WallRunChangeState() {
 
 void AShooterCharacter::WallRunJump()
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov || !CharMov->CanWallRunJump())
 		return;
 
@@ -1583,27 +1633,14 @@ void AShooterCharacter::WallRunJump()
 	CharMov->AddImpulse(GetActorForwardVector() * CharMov->WallRunJumpLateralAcceleration);
 }
 
-void AShooterCharacter::WallRunMoveToNewPosition() 
-{
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
-	if (!CharMov)
-		return;
-
-	/*A new grip point on the wall has already been computed,
-	* and the player is simply moved in front of it*/
-
-	FVector NewPosition = CharMov->GetWallRunLastHitPoint()->ImpactPoint + CharMov->GetWallRunLastHitPoint()->ImpactNormal * CharMov->WallRunMaxWallSlidingDistance;
-	TeleportTo(NewPosition, GetActorRotation());
-}
-
 void AShooterCharacter::WallRunComputeMovementDirection()
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return;
 
-	FVector WallNormal2D = CharMov->GetWallRunLastHitPoint()->ImpactNormal.GetSafeNormal2D();
-	FVector InvertedRay2D = GetActorRotation().Vector().GetSafeNormal2D(); //(GetActorLocation() - CharMov->GetWallRunLastHitPoint()->ImpactPoint).GetSafeNormal2D();
+	FVector WallNormal2D = CharMov->GetWallRunLastGripPoint().GetImpactNormal().GetSafeNormal2D();
+	FVector InvertedRay2D = GetActorRotation().Vector().GetSafeNormal2D(); //(GetActorLocation() - CharMov->GetWallRunLastGripPoint().GetImpactPoint()).GetSafeNormal2D();
 
 	FVector VerticalVector = FVector::CrossProduct(WallNormal2D, InvertedRay2D).GetSafeNormal();
 	FVector LateralVector = FVector::CrossProduct(VerticalVector, WallNormal2D);
@@ -1613,7 +1650,7 @@ void AShooterCharacter::WallRunComputeMovementDirection()
 
 bool AShooterCharacter::WallRunCalculateNewWallGripPoint(double DeltaTime)
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return false;
 	
@@ -1621,42 +1658,40 @@ bool AShooterCharacter::WallRunCalculateNewWallGripPoint(double DeltaTime)
 	and then I check what's the nearest grip point, if there is any.*/
 
 	FVector NewPlayerSupposedPosition = GetActorLocation() + CharMov->GetWallRunFlowingDirection() * CharMov->WallRunSpeed * DeltaTime;
-	FVector RayDirection = CharMov->GetWallRunLastHitPoint()->ImpactNormal * (-1);
+	FVector RayDirection = CharMov->GetWallRunLastGripPoint().GetImpactNormal() * (-1);
 	float RayLength = GetCapsuleComponent()->GetScaledCapsuleRadius() + CharMov->WallRunMaxWallDetectionDistance;
 	FVector EndRayPoint = NewPlayerSupposedPosition + RayDirection * RayLength;
 
 	/*Collision check must not hit the character itself*/
 	FCollisionQueryParams TraceParams = FCollisionQueryParams(FName(TEXT("WallTrace")), true, this);
 	FHitResult HitDetails = FHitResult(EForceInit::ForceInit);
-	bool bIsHit = GetWorld()->LineTraceSingleByChannel(HitDetails, NewPlayerSupposedPosition, EndRayPoint, ECC_Visibility, TraceParams);
+	bool bIsHit = UShooterWallRunIndex::LineTraceWall(GetWorld(), HitDetails, NewPlayerSupposedPosition, EndRayPoint, TraceParams);
 
-	/* First I check if there is a visible object, 
-	and then I find a grip point onto a collider with a second raycast*/
+	/* A raycast finds a grip point onto a collider,
+	and then I check that there is a visible object along the same ray*/
 
 	if (!bIsHit) {
 		if (GetLocalRole() == ENetRole::ROLE_Authority) {
-			UE_LOG(LogTemp, Warning, TEXT("Server: Not hit anything visible"));
+			UE_LOG(LogTemp, Warning, TEXT("Server: Not hit anything"));
 		}
 		else
-			UE_LOG(LogTemp, Warning, TEXT("Client: Not hit anything visible"));
+			UE_LOG(LogTemp, Warning, TEXT("Client: Not hit anything"));
 		return false;
 	}
 
-	bIsHit = GetWorld()->LineTraceSingleByChannel(HitDetails, NewPlayerSupposedPosition, EndRayPoint, ECC_Pawn, TraceParams);
-
-	if (!bIsHit) {
+	if (!UShooterCharacterMovement::IsWallVisibleAlongRay(GetWorld(), HitDetails, NewPlayerSupposedPosition, EndRayPoint, TraceParams)) {
 		if (GetLocalRole() == ENetRole::ROLE_Authority) {
-			UE_LOG(LogTemp, Warning, TEXT("Server: Not hit anything"));
+			UE_LOG(LogTemp, Warning, TEXT("Server: Not hit anything visible"));
 		}
 		else
-			UE_LOG(LogTemp, Warning, TEXT("Client: Not hit anything"));
+			UE_LOG(LogTemp, Warning, TEXT("Client: Not hit anything visible"));
 		return false;
 	}
 
 	/*If, for any reason, the player finds himself not moving fast enough, or even not moving at all
 	I stop WallRun movement state*/
 
-	if ((CharMov->GetWallRunLastHitPoint()->ImpactPoint - HitDetails.ImpactPoint).Size() < CharMov->WallRunSpeed * DeltaTime /2) {
+	if ((CharMov->GetWallRunLastGripPoint().GetImpactPoint() - HitDetails.ImpactPoint).Size() < CharMov->WallRunSpeed * DeltaTime /2) {
 		if (GetLocalRole() == ENetRole::ROLE_Authority) {
 			UE_LOG(LogTemp, Warning, TEXT("Server: Stuck in position"));
 		}
@@ -1667,7 +1702,7 @@ bool AShooterCharacter::WallRunCalculateNewWallGripPoint(double DeltaTime)
 
 	/*If I'm already performing WallRunning, I want to be sure that the new grip point wall normal
 	* isn't too different from the previous one. Otherwise, it will be considered a different surface*/
-	float AngleDifference = FMath::Abs(CharMov->GetWallRunLastHitPoint()->ImpactNormal.Rotation().Yaw - HitDetails.ImpactNormal.Rotation().Yaw);
+	float AngleDifference = FMath::Abs(CharMov->GetWallRunLastGripPoint().GetImpactNormal().Rotation().Yaw - HitDetails.ImpactNormal.Rotation().Yaw);
 	if (CharMov->WallRunMaxWallAngleVariation < AngleDifference && AngleDifference < 360 - CharMov->WallRunMaxWallAngleVariation) {
 		if (GetLocalRole() == ENetRole::ROLE_Authority) {
 			UE_LOG(LogTemp, Warning, TEXT("Server: Bad Angle difference %f"), FMath::Abs(AngleDifference));
@@ -1684,7 +1719,7 @@ bool AShooterCharacter::WallRunCalculateNewWallGripPoint(double DeltaTime)
 	FVector NewFlowDirection = OldFlowDirection.ProjectOnTo(NewFlowAxe).GetSafeNormal2D();
 	CharMov->SetWallRunFlowingDirection(NewFlowDirection);
 	
-	CharMov->SetWallRunLastHitPoint(HitDetails);
+	CharMov->SetWallRunLastGripPoint(FShooterWallGripPoint(HitDetails));
 	
 	
 	return true;
@@ -1692,7 +1727,7 @@ bool AShooterCharacter::WallRunCalculateNewWallGripPoint(double DeltaTime)
 
 void AShooterCharacter::WallRunSetEndingMovement()
 {
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(GetMovementComponent());
+	UShooterCharacterMovement* CharMov = GetShooterCharacterMovement();
 	if (!CharMov)
 		return;
 	/*When the WallRun ends, for any reason, the player will still have a residual velocity*/
@@ -2,6 +2,360 @@
 
 #include "ShooterGame.h"
 #include "Player/ShooterCharacterMovement.h"
+#include "Player/ShooterWallRunIndex.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+static int32 ShooterAsyncWallProbe = 0;
+FAutoConsoleVariableRef CVarShooterAsyncWallProbe(
+	TEXT("p.ShooterAsyncWallProbe"),
+	ShooterAsyncWallProbe,
+	TEXT("WallRun wall detection mode.\n")
+	TEXT("0: synchronous LineTraces on request, 1: async LineTraces submitted every frame for locally controlled pawns, consumed on next frame by the live move only.\n")
+	TEXT("Moves of remote players on the server and client replays always probe synchronously, see p.ShooterWallProbeOverlap"),
+	ECVF_Default);
+
+static int32 ShooterWallProbeOverlap = 1;
+FAutoConsoleVariableRef CVarShooterWallProbeOverlap(
+	TEXT("p.ShooterWallProbeOverlap"),
+	ShooterWallProbeOverlap,
+	TEXT("Synchronous WallRun wall detection, used by the server for remote players' moves, by replays and without the async probe.\n")
+	TEXT("0: one scene trace per ray, 1: a single overlap of the rays' ring, with rays traced against the overlapped bodies only"),
+	ECVF_Default);
+
+static float ShooterTeleportQueryCacheLifetime = 0.5f;
+FAutoConsoleVariableRef CVarShooterTeleportQueryCacheLifetime(
+	TEXT("p.ShooterTeleportQueryCacheLifetime"),
+	ShooterTeleportQueryCacheLifetime,
+	TEXT("Seconds a resolved Teleport destination can be reused for the same requested destination"),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Wall probe"), STAT_ShooterWallProbe, STATGROUP_ShooterMovement);
+DECLARE_CYCLE_STAT(TEXT("Teleport resolution"), STAT_ShooterTeleportResolution, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Teleport cache hits"), STAT_ShooterTeleportCacheHits, STATGROUP_ShooterMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Teleport resolutions/s"), STAT_ShooterTeleportResolutionsPerSecond, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wall probe traces"), STAT_ShooterWallProbeTraces, STATGROUP_ShooterMovement);
+DECLARE_CYCLE_STAT(TEXT("Saved moves replay"), STAT_ShooterReplay, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replayed moves"), STAT_ShooterReplayedMoves, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: no ability"), STAT_ShooterCorrectionsNoAbility, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: Teleport"), STAT_ShooterCorrectionsTeleport, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: WallJump"), STAT_ShooterCorrectionsWallJump, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: JetpackSprint"), STAT_ShooterCorrectionsJetpackSprint, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: WallRun"), STAT_ShooterCorrectionsWallRun, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: WallRunJump"), STAT_ShooterCorrectionsWallRunJump, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Server ability state mismatches"), STAT_ShooterServerStateMismatches, STATGROUP_ShooterMovement);
+
+CSV_DEFINE_CATEGORY(ShooterMovement, true);
+
+/*Wall traces cast since startup, see UShooterCharacterMovement::CountWallTraces()*/
+static uint64 ShooterWallTraceCount = 0;
+
+/**
+* Saved move layout before FShooterWallGripPoint, with a full FHitResult.
+* It's only allocated by ShooterMovement.SavedMoveMemory, as a reference.
+*/
+class FSavedMove_Character_FullHitResult : public FSavedMove_Character
+{
+public:
+	uint8 SavedMove_AbilityTriggers;
+	uint8 SavedMove_AbilityAvailable;
+	double SavedMove_JetpackEnergy;
+	double SavedMove_WallRunMaxEndingTime;
+	double SavedMove_WallRunMaxJumpTime;
+	bool bSavedMove_WallRunJumpOnce;
+	bool bSavedMove_bWallRunFlowing;
+	FHitResult SavedMove_WallRunLastHitPoint;
+	FVector SavedMove_WallRunFlowingDirection;
+};
+
+/*Memory actually allocated for a saved move, including allocator overhead. Falls back to its size if the allocator can't tell*/
+static SIZE_T GetSavedMoveAllocatedBytes(const FSavedMove_Character* SavedMove, SIZE_T MoveSize)
+{
+	const SIZE_T AllocatedBytes = SavedMove ? FMemory::GetAllocSize(const_cast<FSavedMove_Character*>(SavedMove)) : 0;
+	return AllocatedBytes ? AllocatedBytes : MoveSize;
+}
+
+FAutoConsoleCommandWithWorld ShooterSavedMoveMemoryCmd(TEXT("ShooterMovement.SavedMoveMemory"), TEXT("Prints memory allocated for saved moves of locally predicted characters"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+{
+	/*Both layouts are allocated the way FNetworkPredictionData_Client_Character_Upgraded allocates moves, and measured by the allocator*/
+	FSavedMove_Character_Upgraded* CompactMove = new FSavedMove_Character_Upgraded();
+	FSavedMove_Character_FullHitResult* FullHitResultMove = new FSavedMove_Character_FullHitResult();
+	const SIZE_T CompactBytes = GetSavedMoveAllocatedBytes(CompactMove, sizeof(FSavedMove_Character_Upgraded));
+	const SIZE_T FullHitResultBytes = GetSavedMoveAllocatedBytes(FullHitResultMove, sizeof(FSavedMove_Character_FullHitResult));
+	delete CompactMove;
+	delete FullHitResultMove;
+
+	UE_LOG(LogShooter, Display, TEXT("Allocated bytes per saved move: %d (sizeof %d, FShooterWallGripPoint %d). With a full FHitResult: %d (sizeof %d, FHitResult %d)"),
+		(int32)CompactBytes, (int32)sizeof(FSavedMove_Character_Upgraded), (int32)sizeof(FShooterWallGripPoint),
+		(int32)FullHitResultBytes, (int32)sizeof(FSavedMove_Character_FullHitResult), (int32)sizeof(FHitResult));
+
+	for (AShooterCharacter* ShooterCharacter : TActorRange<AShooterCharacter>(World))
+	{
+		UShooterCharacterMovement* CharMov = ShooterCharacter->GetShooterCharacterMovement();
+		if (!CharMov || !CharMov->HasPredictionData_Client())
+			continue;
+
+		/*Every move owned by the prediction data is measured, whether it's waiting for an ack or free for reuse*/
+		const FNetworkPredictionData_Client_Character* ClientData = CharMov->GetPredictionData_Client_Character();
+		SIZE_T AllocatedBytes = 0;
+		int32 AllocatedMoves = 0;
+		for (const TArray<FSavedMovePtr>* Moves : { &ClientData->SavedMoves, &ClientData->FreeMoves })
+		{
+			for (const FSavedMovePtr& Move : *Moves)
+			{
+				AllocatedBytes += GetSavedMoveAllocatedBytes(Move.Get(), sizeof(FSavedMove_Character_Upgraded));
+				AllocatedMoves++;
+			}
+		}
+
+		UE_LOG(LogShooter, Display, TEXT("%s: %d allocated saved moves (max %d), %d bytes (%d with a full FHitResult)"), *GetNameSafe(ShooterCharacter), AllocatedMoves, ClientData->MaxSavedMoveCount,
+			(int32)AllocatedBytes, (int32)(AllocatedMoves * FullHitResultBytes));
+	}
+}));
+
+FAutoConsoleCommandWithWorldAndArgs ShooterDumpReplayStatsCmd(TEXT("ShooterMovement.DumpReplayStats"), TEXT("Writes prediction cost counters of every character to a CSV file in the profiling directory. Usage: ShooterMovement.DumpReplayStats [FileName]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+{
+	FString Csv = TEXT("Character,Role,Replays,ReplayedMoves,ReplayMs,ServerStateMismatches,MaxCorrectionError,AvgCorrectionError,CorrectionsNoAbility");
+	for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++)
+		Csv += FString::Printf(TEXT(",Corrections%s"), UShooterCharacterMovement::GetAbilityDesc((EShooterMovementAbility)i).Name);
+	Csv += LINE_TERMINATOR;
+
+	for (AShooterCharacter* ShooterCharacter : TActorRange<AShooterCharacter>(World))
+	{
+		const UShooterCharacterMovement* CharMov = ShooterCharacter->GetShooterCharacterMovement();
+		if (!CharMov)
+			continue;
+
+		const FShooterMovementReplayStats& Stats = CharMov->GetReplayStats();
+		Csv += FString::Printf(TEXT("%s,%s,%u,%u,%.3f,%u,%.3f,%.3f,%u"), *GetNameSafe(ShooterCharacter), *UEnum::GetValueAsString(ShooterCharacter->GetLocalRole()),
+			Stats.Replays, Stats.ReplayedMoves, Stats.ReplaySeconds * 1000.0, Stats.ServerStateMismatches,
+			Stats.MaxCorrectionError, Stats.MeasuredCorrections ? Stats.CorrectionErrorSum / Stats.MeasuredCorrections : 0.0, Stats.CorrectionsWithoutAbility);
+		for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++)
+			Csv += FString::Printf(TEXT(",%u"), Stats.CorrectionsPerAbility[i]);
+		Csv += LINE_TERMINATOR;
+	}
+
+	const FString FileName = Args.Num() > 0 ? Args[0] : FString::Printf(TEXT("ReplayStats-%s.csv"), *FDateTime::Now().ToString());
+	const FString FilePath = FPaths::ProfilingDir() / TEXT("ShooterMovement") / FileName;
+	if (FFileHelper::SaveStringToFile(Csv, *FilePath))
+		UE_LOG(LogShooter, Display, TEXT("Replay stats written to %s"), *FilePath);
+	else
+		UE_LOG(LogShooter, Warning, TEXT("Can't write replay stats to %s"), *FilePath);
+}));
+
+FAutoConsoleCommandWithWorldAndArgs ShooterTypedPointerBenchmarkCmd(TEXT("ShooterMovement.BenchmarkTypedPointers"), TEXT("Compares Cast<> lookups against cached typed pointers over spawned pawns. Usage: ShooterMovement.BenchmarkTypedPointers [Pawns=1000] [Passes=100]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+{
+	const int32 NumPawns = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+	const int32 NumPasses = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+
+	AShooterGameMode* GameMode = World ? World->GetAuthGameMode<AShooterGameMode>() : nullptr;
+	if (!GameMode)
+	{
+		UE_LOG(LogShooter, Warning, TEXT("ShooterMovement.BenchmarkTypedPointers: pawns can only be spawned by the server"));
+		return;
+	}
+
+	/*Pawns are spawned on a grid high above the level, and destroyed as soon as both paths are measured, before they ever tick*/
+	UClass* PawnClass = GameMode->BotPawnClass ? *GameMode->BotPawnClass : AShooterCharacter::StaticClass();
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<AShooterCharacter*> ShooterCharacters;
+	ShooterCharacters.Reserve(NumPawns);
+	for (int32 i = 0; i < NumPawns; i++)
+	{
+		const FVector Location((i % 32) * 200.0f, (i / 32) * 200.0f, 100000.0f);
+		AShooterCharacter* ShooterCharacter = World->SpawnActor<AShooterCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnInfo);
+		if (ShooterCharacter && ShooterCharacter->GetShooterCharacterMovement())
+			ShooterCharacters.Add(ShooterCharacter);
+	}
+
+	if (ShooterCharacters.Num() < NumPawns)
+		UE_LOG(LogShooter, Warning, TEXT("ShooterMovement.BenchmarkTypedPointers: only %d of %d pawns could be spawned"), ShooterCharacters.Num(), NumPawns);
+
+	/*Each lookup is the one of an ability tick: the character to its movement component and back*/
+	int32 Found = 0;
+
+	const double CastStart = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		for (AShooterCharacter* ShooterCharacter : ShooterCharacters)
+		{
+			UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(ShooterCharacter->GetMovementComponent());
+			Found += (CharMov && Cast<AShooterCharacter>(CharMov->GetCharacterOwner())) ? 1 : 0;
+		}
+	}
+	const double CastSeconds = FPlatformTime::Seconds() - CastStart;
+
+	const double CachedStart = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		for (AShooterCharacter* ShooterCharacter : ShooterCharacters)
+		{
+			UShooterCharacterMovement* CharMov = ShooterCharacter->GetShooterCharacterMovement();
+			Found += (CharMov && CharMov->GetShooterCharacterOwner()) ? 1 : 0;
+		}
+	}
+	const double CachedSeconds = FPlatformTime::Seconds() - CachedStart;
+
+	for (AShooterCharacter* ShooterCharacter : ShooterCharacters)
+		ShooterCharacter->Destroy();
+
+	const int32 NumLookups = FMath::Max(1, ShooterCharacters.Num() * NumPasses);
+	const double CastNs = CastSeconds * 1e9 / NumLookups;
+	const double CachedNs = CachedSeconds * 1e9 / NumLookups;
+	UE_LOG(LogShooter, Display, TEXT("%d pawns, %d passes (%d found): Cast<> %.2f ns/lookup (%.3f ms/pass), cached pointers %.2f ns/lookup (%.3f ms/pass), x%.1f"),
+		ShooterCharacters.Num(), NumPasses, Found, CastNs, CastSeconds * 1000.0 / NumPasses, CachedNs, CachedSeconds * 1000.0 / NumPasses, CachedNs > 0.0 ? CastNs / CachedNs : 0.0);
+
+	/*Results are also kept next to the replay stats, for regression tracking*/
+	const FString Csv = FString::Printf(TEXT("Pawns,Passes,CastNsPerLookup,CachedNsPerLookup,CastMsPerPass,CachedMsPerPass%s%d,%d,%.3f,%.3f,%.4f,%.4f%s"), LINE_TERMINATOR,
+		ShooterCharacters.Num(), NumPasses, CastNs, CachedNs, CastSeconds * 1000.0 / NumPasses, CachedSeconds * 1000.0 / NumPasses, LINE_TERMINATOR);
+	const FString FilePath = FPaths::ProfilingDir() / TEXT("ShooterMovement") / FString::Printf(TEXT("TypedPointers-%s.csv"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Csv, *FilePath))
+		UE_LOG(LogShooter, Display, TEXT("Typed pointer benchmark written to %s"), *FilePath);
+}));
+
+//----------------------------------------------------------------------//
+// Ability registry
+//----------------------------------------------------------------------//
+static_assert(FShooterCharacterNetworkMoveData::INPUT_Teleport == (1 << (uint8)EShooterMovementAbility::Teleport)
+	&& FShooterCharacterNetworkMoveData::INPUT_WallJump == (1 << (uint8)EShooterMovementAbility::WallJump)
+	&& FShooterCharacterNetworkMoveData::INPUT_JetpackSprint == (1 << (uint8)EShooterMovementAbility::JetpackSprint)
+	&& FShooterCharacterNetworkMoveData::INPUT_WallRun == (1 << (uint8)EShooterMovementAbility::WallRun)
+	&& FShooterCharacterNetworkMoveData::INPUT_WallRunJump == (1 << (uint8)EShooterMovementAbility::WallRunJump),
+	"Ability input flags must match EShooterMovementAbility bits");
+static_assert(FShooterCharacterNetworkMoveData::AbilityInputBits >= (int32)EShooterMovementAbility::Count, "Every ability needs an input bit");
+
+/*Abilities are performed in this order by PerformMovement*/
+static const FShooterMovementAbilityDesc ShooterMovementAbilities[(uint8)EShooterMovementAbility::Count] =
+{
+	/*Teleport*/
+	{ TEXT("Teleport"), [](AShooterCharacter& ShooterCharacter, UShooterCharacterMovement& CharMov) { ShooterCharacter.Teleport(); }, nullptr, true, 0, 0 },
+	/*WallJump*/
+	{ TEXT("WallJump"), [](AShooterCharacter& ShooterCharacter, UShooterCharacterMovement& CharMov) { ShooterCharacter.WallJump(); }, nullptr, true, 0, 0 },
+	/*JetpackSprint is a held action: JetpackTick sprints or recharges every move. The player can't WallJump while JetpackSprinting*/
+	{ TEXT("JetpackSprint"), nullptr, [](AShooterCharacter& ShooterCharacter, UShooterCharacterMovement& CharMov, float DeltaTime) { ShooterCharacter.JetpackTick(DeltaTime); }, false,
+		0, 1 << (uint8)EShooterMovementAbility::WallJump },
+	/*WallRun both starts and stops WallRunning. I want the WallRunJump action to have priority over it*/
+	{ TEXT("WallRun"), [](AShooterCharacter& ShooterCharacter, UShooterCharacterMovement& CharMov) { ShooterCharacter.WallRunChangeState(); }, nullptr, true,
+		1 << (uint8)EShooterMovementAbility::WallRunJump, 0 },
+	/*WallRunJump can't be performed twice in a row*/
+	{ TEXT("WallRunJump"), [](AShooterCharacter& ShooterCharacter, UShooterCharacterMovement& CharMov) { ShooterCharacter.WallRunJump(); CharMov.SetWallRunJumpOnce(false); }, nullptr, true, 0, 0 },
+};
+
+//----------------------------------------------------------------------//
+// FShooterMovementReplayStats
+//----------------------------------------------------------------------//
+FShooterMovementReplayStats::FShooterMovementReplayStats()
+	: CorrectionsWithoutAbility(0)
+	, Replays(0)
+	, ReplayedMoves(0)
+	, ReplaySeconds(0.0)
+	, ServerStateMismatches(0)
+	, MeasuredCorrections(0)
+	, CorrectionErrorSum(0.0)
+	, MaxCorrectionError(0.f)
+{
+	FMemory::Memzero(CorrectionsPerAbility);
+}
+
+//----------------------------------------------------------------------//
+// FShooterWallGripPoint
+//----------------------------------------------------------------------//
+FShooterWallGripPoint::FShooterWallGripPoint()
+	: PackedImpactPoint(0)
+{
+	QuantizedNormal[0] = QuantizedNormal[1] = QuantizedNormal[2] = 0;
+}
+
+FShooterWallGripPoint::FShooterWallGripPoint(const FHitResult& Hit)
+	: PackedImpactPoint(0)
+	, Component(Hit.Component)
+{
+	const int32 MaxCoordinate = (1 << (ImpactPointBits - 1)) - 1;
+	const uint64 CoordinateMask = (1ull << ImpactPointBits) - 1;
+
+	for (int32 i = 0; i < 3; i++) {
+		/*Points out of range are clamped, ShooterGame levels are much smaller than that*/
+		const int32 Coordinate = FMath::Clamp(FMath::RoundToInt(Hit.ImpactPoint[i] / ImpactPointResolution), -MaxCoordinate, MaxCoordinate);
+		PackedImpactPoint |= ((uint64)(uint32)Coordinate & CoordinateMask) << (i * ImpactPointBits);
+		QuantizedNormal[i] = (int16)FMath::RoundToInt(FMath::Clamp(Hit.ImpactNormal[i], -1.f, 1.f) * MAX_int16);
+	}
+}
+
+FVector FShooterWallGripPoint::GetImpactPoint() const
+{
+	const uint64 CoordinateMask = (1ull << ImpactPointBits) - 1;
+
+	FVector ImpactPoint;
+	for (int32 i = 0; i < 3; i++) {
+		/*Sign extension of each ImpactPointBits field*/
+		const int32 Coordinate = ((int32)(((PackedImpactPoint >> (i * ImpactPointBits)) & CoordinateMask) << (32 - ImpactPointBits))) >> (32 - ImpactPointBits);
+		ImpactPoint[i] = Coordinate * ImpactPointResolution;
+	}
+	return ImpactPoint;
+}
+
+FVector FShooterWallGripPoint::GetImpactNormal() const
+{
+	return FVector(QuantizedNormal[0], QuantizedNormal[1], QuantizedNormal[2]) / MAX_int16;
+}
+
+UPrimitiveComponent* FShooterWallGripPoint::GetComponent() const
+{
+	return Component.Get();
+}
+
+//----------------------------------------------------------------------//
+// FShooterCharacterNetworkMoveData
+//----------------------------------------------------------------------//
+FShooterCharacterNetworkMoveData::FShooterCharacterNetworkMoveData()
+	: AbilityInputs(0)
+	, AbilityState(0)
+{
+}
+
+void FShooterCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	FCharacterNetworkMoveData::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	/*Saved moves are always allocated by FNetworkPredictionData_Client_Character_Upgraded*/
+	const FSavedMove_Character_Upgraded& UpgradedMove = static_cast<const FSavedMove_Character_Upgraded&>(ClientMove);
+	AbilityInputs = UpgradedMove.GetAbilityInputs();
+	AbilityState = UpgradedMove.GetAbilityState();
+}
+
+uint8 FShooterCharacterNetworkMoveData::PackAbilityState(uint8 AbilityAvailable, bool bWallRunFlowing, bool bWallRunJumpOnce)
+{
+	/*STATE_Can... flags are the availability bits of the first abilities*/
+	uint8 State = AbilityAvailable & (STATE_CanTeleport | STATE_CanWallJump | STATE_CanJetpackSprint | STATE_CanWallRun);
+
+	if (bWallRunFlowing)
+		State |= STATE_WallRunFlowing;
+	if (bWallRunJumpOnce)
+		State |= STATE_WallRunJumpOnce;
+
+	return State;
+}
+
+bool FShooterCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	FCharacterNetworkMoveData::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	Ar.SerializeBits(&AbilityInputs, AbilityInputBits);
+	Ar.SerializeBits(&AbilityState, AbilityStateBits);
+
+	return !Ar.IsError();
+}
+
+FShooterCharacterNetworkMoveDataContainer::FShooterCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &ShooterMoveData[0];
+	PendingMoveData = &ShooterMoveData[1];
+	OldMoveData = &ShooterMoveData[2];
+}
 
 //----------------------------------------------------------------------//
 // UPawnMovementComponent
@@ -9,24 +363,36 @@
 UShooterCharacterMovement::UShooterCharacterMovement(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
-	SetCanTeleport(true);
-	SetCanWallJump(true);
-	SetCanJetpackSprint(true);
-	SetCanWallRun(true);
-
-	SetTriggeringTeleport(false);
-	SetTriggeringWallJump(false);
-	SetTriggeringJetpackSprint(false);
-	SetTriggeringWallRun(false);
-	SetTriggeringWallRunJump(false);
+	SetAbilityAvailable((uint8)((1 << (uint8)EShooterMovementAbility::Count) - 1));
+	SetAbilityTriggers(0);
 
 	SetWallRunFlowing(false);
+
+	WallProbeStart = FVector::ZeroVector;
+	WallProbeForwardRay = FVector::ZeroVector;
+	bWallProbeHit = false;
+	WallProbeResultFrame = 0;
+
+	bAbilityStateMismatch = false;
+
+	CurrentMoveTimeStamp = 0.f;
+	bMoveTimeStampValid = false;
+	LastOneShotTimeStamp = -1.f;
+	AbilitySubstepClock = 0.f;
+	bWallRunSubstepPending = false;
+	WallRunSubstepTimeLeft = 0.f;
+	bTeleportQueryValid = false;
+	TeleportQueryTime = 0.f;
+	TeleportResolutionsInWindow = 0;
+	TeleportResolutionsLastWindow = 0;
+	TeleportResolutionsWindowStart = 0.f;
+	SetNetworkMoveDataContainer(ShooterNetworkMoveDataContainer);
 }
 
 
 bool UShooterCharacterMovement::IsWallInFrontOfPlayerValid() const
 {
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(CharacterOwner);
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
 	if (!ShooterCharacter)
 		return false;
 
@@ -63,7 +429,7 @@ bool UShooterCharacterMovement::IsWallInFrontOfPlayerValid() const
 
 bool UShooterCharacterMovement::IsWallNearPlayerValid(bool bSetGripPoint)
 {
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(CharacterOwner);
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
 	if (!ShooterCharacter)
 		return false;
 
@@ -87,7 +453,7 @@ bool UShooterCharacterMovement::IsWallNearPlayerValid(bool bSetGripPoint)
 		* because of requirements.
 		*/
 		FVector NewNormal = HitDetails.ImpactNormal;
-		FVector OldNormal = GetWallRunLastHitPoint()->ImpactNormal;
+		FVector OldNormal = GetWallRunLastGripPoint().GetImpactNormal();
 
 		float AngleDifference = FMath::Abs(NewNormal.Rotation().Yaw - OldNormal.Rotation().Yaw);
 		if (AngleDifference < WallRunMaxWallAngleVariation || 360 - WallRunMaxWallAngleVariation < AngleDifference) {			
@@ -97,38 +463,46 @@ bool UShooterCharacterMovement::IsWallNearPlayerValid(bool bSetGripPoint)
 	}
 
 	if(bSetGripPoint)
-		WallRunLastHitPoint = HitDetails;
+		WallRunLastGripPoint = FShooterWallGripPoint(HitDetails);
 
 	return true;
 }
 
 bool UShooterCharacterMovement::CircleTraceSingleByChannel(struct FHitResult& OutHit, const FVector& Start, const FVector& ForwardRay, uint8 RaysNumber) const
 {
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(CharacterOwner);
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
 	if (!ShooterCharacter)
 		return false;
 
+	/*When the async probe is enabled, I use the result consumed this frame if it was cast from the same rays.
+	* Otherwise, for example on the very first falling frame, in replays or on the server, I fall back to the synchronous traces*/
+	if (CanUseWallProbeResult(Start, ForwardRay)) {
+		if (bWallProbeHit)
+			OutHit = WallProbeHit;
+		return bWallProbeHit;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterWallProbe);
+
 	/*Collision check must not hit the character itself*/
 	FCollisionQueryParams TraceParams = FCollisionQueryParams(FName(TEXT("WallTrace")), true, ShooterCharacter);
 
+	if (ShooterWallProbeOverlap)
+		return CircleTraceByOverlap(OutHit, Start, ForwardRay, RaysNumber, TraceParams);
 
 	float MinDist = FLT_MAX;
 	for (int i = 0; i < RaysNumber; i++) {
 		/*Each iteration casts a ray towards a different direction around the character*/
 		FVector End = Start + ForwardRay.RotateAngleAxis((360 / RaysNumber) * i, FVector::UpVector);
 		FHitResult HitDetails = FHitResult(EForceInit::ForceInit);
-		bool bIsHit = GetWorld()->LineTraceSingleByChannel(HitDetails, Start, End, ECC_Visibility, TraceParams);
+		bool bIsHit = UShooterWallRunIndex::LineTraceWall(GetWorld(), HitDetails, Start, End, TraceParams);
 
-		if (!bIsHit)
+		/*The grip point is found onto the collider, and there must be a visible wall along the same ray*/
+		if (!bIsHit || !IsWallVisibleAlongRay(GetWorld(), HitDetails, Start, End, TraceParams))
 			continue;
 
-		/*I want to be sure that there is a visible object as a wall, detected by the first LineTrace,
-		* but I want to find a grip point onto the collider, so I cast a second ray to find it*/
-
-		bIsHit = GetWorld()->LineTraceSingleByChannel(HitDetails, Start, End, ECC_Pawn, TraceParams);
-
 		/*I want to return the closest grip point to the player*/
-		if (bIsHit && HitDetails.Distance < MinDist) {
+		if (HitDetails.Distance < MinDist) {
 			OutHit = HitDetails;
 			MinDist = OutHit.Distance;
 		}
@@ -138,6 +512,223 @@ bool UShooterCharacterMovement::CircleTraceSingleByChannel(struct FHitResult& Ou
 	return MinDist != FLT_MAX;
 }
 
+/*Nearest blocking hit of the segment against overlapped bodies only, without any scene query. InOutHit is kept if nothing is hit*/
+static bool LineTraceOverlappedBodies(const TArray<FOverlapResult>& Overlaps, const FVector& Start, const FVector& End, bool bTraceComplex, FHitResult& InOutHit)
+{
+	bool bIsHit = false;
+	for (const FOverlapResult& Overlap : Overlaps) {
+		UPrimitiveComponent* Component = Overlap.GetComponent();
+		if (!Overlap.bBlockingHit || !Component)
+			continue;
+
+		/*Instanced meshes report the overlapped instance, each one has its own body*/
+		const FBodyInstance* BodyInstance = Component->GetBodyInstance(NAME_None, true, Overlap.ItemIndex);
+		FHitResult BodyHit;
+		if (!BodyInstance || !BodyInstance->LineTrace(BodyHit, Start, End, bTraceComplex))
+			continue;
+
+		if (!bIsHit || BodyHit.Distance < InOutHit.Distance) {
+			InOutHit = BodyHit;
+			InOutHit.bBlockingHit = true;
+			InOutHit.Component = Component;
+			InOutHit.Actor = Overlap.GetActor();
+			InOutHit.Item = Overlap.ItemIndex;
+			bIsHit = true;
+		}
+	}
+
+	return bIsHit;
+}
+
+bool UShooterCharacterMovement::CircleTraceByOverlap(FHitResult& OutHit, const FVector& Start, const FVector& ForwardRay, uint8 RaysNumber, const FCollisionQueryParams& Params) const
+{
+	UWorld* World = GetWorld();
+	const FCollisionShape Ring = FCollisionShape::MakeSphere(ForwardRay.Size());
+
+	/*When the walls index covers every ray, static walls come from it and the overlap only looks for movable bodies*/
+	TArray<FHitResult, TInlineAllocator<16>> StaticHits;
+	StaticHits.SetNum(RaysNumber);
+	bool bIndexed = true;
+	for (int i = 0; i < RaysNumber && bIndexed; i++) {
+		FVector End = Start + ForwardRay.RotateAngleAxis((360 / RaysNumber) * i, FVector::UpVector);
+		bIndexed = UShooterWallRunIndex::RaycastStatic(World, Start, End, StaticHits[i]);
+	}
+
+	FCollisionQueryParams PawnParams(Params);
+	if (bIndexed)
+		PawnParams.MobilityType = EQueryMobilityType::Dynamic;
+
+	TArray<FOverlapResult> PawnOverlaps;
+	World->OverlapMultiByChannel(PawnOverlaps, Start, FQuat::Identity, ECC_Pawn, Ring, PawnParams);
+	CountWallTraces(1);
+
+	TArray<FOverlapResult> VisibilityOverlaps;
+	bool bVisibilityOverlapDone = false;
+
+	float MinDist = FLT_MAX;
+	for (int i = 0; i < RaysNumber; i++) {
+		FVector End = Start + ForwardRay.RotateAngleAxis((360 / RaysNumber) * i, FVector::UpVector);
+
+		/*Movable bodies are only looked for in front of the static wall*/
+		FHitResult HitDetails = bIndexed ? StaticHits[i] : FHitResult(EForceInit::ForceInit);
+		const FVector PawnEnd = HitDetails.bBlockingHit ? HitDetails.Location : End;
+		LineTraceOverlappedBodies(PawnOverlaps, Start, PawnEnd, Params.bTraceComplex, HitDetails);
+		if (!HitDetails.bBlockingHit)
+			continue;
+
+		/*Same rule as IsWallVisibleAlongRay(), against visible bodies around the ring*/
+		const UPrimitiveComponent* HitComponent = HitDetails.GetComponent();
+		if (!HitComponent || HitComponent->GetCollisionResponseToChannel(ECC_Visibility) != ECR_Block) {
+			if (!bVisibilityOverlapDone) {
+				World->OverlapMultiByChannel(VisibilityOverlaps, Start, FQuat::Identity, ECC_Visibility, Ring, Params);
+				CountWallTraces(1);
+				bVisibilityOverlapDone = true;
+			}
+
+			FHitResult VisibleHit(EForceInit::ForceInit);
+			if (!LineTraceOverlappedBodies(VisibilityOverlaps, Start, End, Params.bTraceComplex, VisibleHit))
+				continue;
+		}
+
+		if (HitDetails.Distance < MinDist) {
+			OutHit = HitDetails;
+			OutHit.TraceStart = Start;
+			OutHit.TraceEnd = End;
+			OutHit.Time = HitDetails.Distance / FMath::Max(ForwardRay.Size(), KINDA_SMALL_NUMBER);
+			MinDist = OutHit.Distance;
+		}
+	}
+
+	return MinDist != FLT_MAX;
+}
+
+bool UShooterCharacterMovement::IsWallVisibleAlongRay(UWorld* World, const FHitResult& GripHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params)
+{
+	if (!GripHit.bBlockingHit)
+		return false;
+
+	/*A grip collider that blocks visibility is a visible wall by itself*/
+	const UPrimitiveComponent* HitComponent = GripHit.GetComponent();
+	if (HitComponent && HitComponent->GetCollisionResponseToChannel(ECC_Visibility) == ECR_Block)
+		return true;
+
+	/*Otherwise, like an invisible collider in front of a visible mesh, I look for any visible object along the ray.
+	* Invisible colliders alone, such as area limits, block pawns but don't block visibility*/
+	CountWallTraces(1);
+	return World->LineTraceTestByChannel(Start, End, ECC_Visibility, Params);
+}
+
+void UShooterCharacterMovement::CountWallTraces(uint32 Count)
+{
+	ShooterWallTraceCount += Count;
+	INC_DWORD_STAT_BY(STAT_ShooterWallProbeTraces, Count);
+}
+
+uint64 UShooterCharacterMovement::GetWallTraceCount()
+{
+	return ShooterWallTraceCount;
+}
+
+bool UShooterCharacterMovement::ShouldProbeWallAsync() const
+{
+	/*Moves of remote players are performed by the server when they're received, and they never use the probe*/
+	if (!CharacterOwner || !CharacterOwner->IsLocallyControlled())
+		return false;
+
+	/*Same preconditions as CanWallRun(), the probe is useless otherwise*/
+	return IsAvailable(EShooterMovementAbility::WallRun) && IsFalling();
+}
+
+void UShooterCharacterMovement::SubmitWallProbeAsync()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterWallProbe);
+
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
+	if (!ShooterCharacter)
+		return;
+
+	/*Same rays as IsWallNearPlayerValid(), from the position the next move will start from*/
+	WallProbeStart = ShooterCharacter->GetActorLocation();
+	FVector Direction = ShooterCharacter->GetActorRotation().Vector();
+	WallProbeForwardRay = Direction * (ShooterCharacter->GetCapsuleComponent()->GetScaledCapsuleRadius() + WallRunMaxWallDetectionDistance);
+
+	FCollisionQueryParams TraceParams = FCollisionQueryParams(FName(TEXT("WallTrace")), true, ShooterCharacter);
+	FCollisionQueryParams DynamicParams(TraceParams);
+	DynamicParams.MobilityType = EQueryMobilityType::Dynamic;
+
+	/*The async trace API takes one request per ray and channel. They all run in the same async trace task, at the end of the frame,
+	* so visibility traces are submitted along with pawn traces, even though most grip colliders make them useless*/
+	UWorld* World = GetWorld();
+	for (int i = 0; i < WallRunWallDetectionRayNumber; i++) {
+		FShooterWallProbeRay& Ray = WallProbeRays.AddDefaulted_GetRef();
+		Ray.Start = WallProbeStart;
+		Ray.End = WallProbeStart + WallProbeForwardRay.RotateAngleAxis((360 / WallRunWallDetectionRayNumber) * i, FVector::UpVector);
+
+		if (UShooterWallRunIndex::RaycastStatic(World, Ray.Start, Ray.End, Ray.StaticHit)) {
+			const FVector DynamicEnd = Ray.StaticHit.bBlockingHit ? Ray.StaticHit.Location : Ray.End;
+			Ray.PawnHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Ray.Start, DynamicEnd, ECC_Pawn, DynamicParams);
+		}
+		else
+			Ray.PawnHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Ray.Start, Ray.End, ECC_Pawn, TraceParams);
+
+		Ray.VisibilityHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Ray.Start, Ray.End, ECC_Visibility, TraceParams);
+	}
+	CountWallTraces(WallRunWallDetectionRayNumber * 2);
+}
+
+void UShooterCharacterMovement::ConsumeWallProbeAsync()
+{
+	if (WallProbeRays.Num() == 0)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterWallProbe);
+
+	UWorld* World = GetWorld();
+	float MinDist = FLT_MAX;
+	for (const FShooterWallProbeRay& Ray : WallProbeRays) {
+		FTraceDatum PawnData;
+		FTraceDatum VisibilityData;
+		if (!World->QueryTraceData(Ray.PawnHandle, PawnData) || !World->QueryTraceData(Ray.VisibilityHandle, VisibilityData))
+			continue;
+
+		/*A movable body in front of the static wall is the grip collider*/
+		const FHitResult* PawnHit = PawnData.OutHits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+		if (!PawnHit && Ray.StaticHit.bBlockingHit)
+			PawnHit = &Ray.StaticHit;
+		if (!PawnHit)
+			continue;
+
+		/*Same rule as IsWallVisibleAlongRay(), with the visibility trace submitted along with the pawn one*/
+		const UPrimitiveComponent* HitComponent = PawnHit->GetComponent();
+		const bool bGripBlocksVisibility = HitComponent && HitComponent->GetCollisionResponseToChannel(ECC_Visibility) == ECR_Block;
+		if (!bGripBlocksVisibility && !VisibilityData.OutHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; }))
+			continue;
+
+		if (PawnHit->Distance < MinDist) {
+			WallProbeHit = *PawnHit;
+			WallProbeHit.TraceEnd = Ray.End;
+			WallProbeHit.Time = PawnHit->Distance / FMath::Max((Ray.End - Ray.Start).Size(), KINDA_SMALL_NUMBER);
+			MinDist = PawnHit->Distance;
+		}
+	}
+
+	bWallProbeHit = MinDist != FLT_MAX;
+	WallProbeResultFrame = GFrameCounter;
+
+	WallProbeRays.Reset();
+}
+
+bool UShooterCharacterMovement::CanUseWallProbeResult(const FVector& Start, const FVector& ForwardRay) const
+{
+	if (!ShooterAsyncWallProbe || WallProbeResultFrame != GFrameCounter)
+		return false;
+
+	/*Replays (bClientUpdating) and moves received from a client (bMoveTimeStampValid) must trace from their own position*/
+	if (bClientUpdating || bMoveTimeStampValid || !CharacterOwner || !CharacterOwner->IsLocallyControlled())
+		return false;
+
+	return Start.Equals(WallProbeStart, KINDA_SMALL_NUMBER) && ForwardRay.Equals(WallProbeForwardRay, KINDA_SMALL_NUMBER);
+}
 
 
 
@@ -145,7 +736,6 @@ float UShooterCharacterMovement::GetMaxSpeed() const
 {
 	float MaxSpeed = Super::GetMaxSpeed();
 
-	const AShooterCharacter* ShooterCharacterOwner = Cast<AShooterCharacter>(PawnOwner);
 	if (ShooterCharacterOwner)
 	{
 		if (ShooterCharacterOwner->IsTargeting())
@@ -161,102 +751,302 @@ float UShooterCharacterMovement::GetMaxSpeed() const
 	return MaxSpeed;
 }
 
-void UShooterCharacterMovement::PerformMovement(float DeltaTime) {
-
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(CharacterOwner);
-	if (GetTriggeringTeleport()) {
-		ShooterCharacter->Teleport();
-		SetTriggeringTeleport(false);
+void UShooterCharacterMovement::PhysCustom(float deltaTime, int32 Iterations)
+{
+	if (MovementMode == MOVE_WallRunning) {
+		if (bFixedAbilitySubsteps)
+			PhysWallRunningSubstepped(deltaTime, Iterations);
+		else
+			PhysWallRunning(deltaTime, Iterations);
+		return;
 	}
 
-	if (GetTriggeringWallJump()) {
-		ShooterCharacter->WallJump();
-		SetTriggeringWallJump(false);
+	Super::PhysCustom(deltaTime, Iterations);
+}
+
+void UShooterCharacterMovement::PhysWallRunning(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+		return;
+
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
+	if (!ShooterCharacter)
+		return;
+
+	/*I check whether WallRun time limit is over and if another wallgrip point is available*/
+	if (GetWorld()->TimeSeconds >= GetWallRunMaxEndingTime() || !ShooterCharacter->WallRunCalculateNewWallGripPoint(deltaTime)) {
+		ShooterCharacter->WallRunChangeState();
+
+		/*Remaining time is simulated with the new movement mode*/
+		if (!IsWallRunning())
+			StartNewPhysics(deltaTime, Iterations);
+		return;
 	}
 
-	ShooterCharacter->JetpackTick(DeltaTime);
+	Iterations++;
+	bJustTeleported = false;
 
-	if (GetTriggeringWallRunJump()) {
-		ShooterCharacter->WallRunJump();
-		SetTriggeringWallRunJump(false);
-		SetWallRunJumpOnce(false);
+	/*A new grip point on the wall has already been computed,
+	* and the player is simply moved in front of it*/
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	const FVector NewLocation = GetWallRunLastGripPoint().GetImpactPoint() + GetWallRunLastGripPoint().GetImpactNormal() * WallRunMaxWallSlidingDistance;
+	const FVector Delta = NewLocation - OldLocation;
+
+	FHitResult Hit(1.f);
+	SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+
+	if (Hit.Time < 1.f) {
+		HandleImpact(Hit, deltaTime, Delta);
+		SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
 	}
-	else {
-		/*I want the WallRunJump action to have priority over WallRun
-		* so I check the latter only if the former one fails*/
-		if (GetTriggeringWallRun()) {
+
+	if (!bJustTeleported)
+		Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / deltaTime;
+}
+
+void UShooterCharacterMovement::PhysWallRunningSubstepped(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+		return;
+
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
+	if (!ShooterCharacter)
+		return;
+
+	/*The next grip point is computed once per substep, on its boundary: it's where the player should be on the next boundary*/
+	if (bWallRunSubstepPending) {
+		bWallRunSubstepPending = false;
+
+		if (GetWorld()->TimeSeconds >= GetWallRunMaxEndingTime() || !ShooterCharacter->WallRunCalculateNewWallGripPoint(GetAbilitySubstepTime())) {
 			ShooterCharacter->WallRunChangeState();
-			SetTriggeringWallRun(false);
+
+			/*Remaining time is simulated with the new movement mode*/
+			if (!IsWallRunning())
+				StartNewPhysics(deltaTime, Iterations);
+			return;
 		}
 	}
-	
-	ShooterCharacter->WallRunTick(DeltaTime);
 
-	Super::PerformMovement(DeltaTime);
+	Iterations++;
+	bJustTeleported = false;
+
+	/*Segments in between boundaries cover their share of the way left to the grip point,
+	* so the player moves every frame and reaches it exactly on the boundary.
+	* The target only depends on the saved grip point, so replays follow the same path*/
+	const float Alpha = WallRunSubstepTimeLeft > deltaTime ? deltaTime / WallRunSubstepTimeLeft : 1.f;
+	WallRunSubstepTimeLeft -= deltaTime;
+
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	const FVector TargetLocation = GetWallRunLastGripPoint().GetImpactPoint() + GetWallRunLastGripPoint().GetImpactNormal() * WallRunMaxWallSlidingDistance;
+	const FVector Delta = (TargetLocation - OldLocation) * Alpha;
+
+	FHitResult Hit(1.f);
+	SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
 
+	if (Hit.Time < 1.f) {
+		HandleImpact(Hit, deltaTime, Delta);
+		SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
+	}
+
+	if (!bJustTeleported)
+		Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / deltaTime;
 }
 
-void UShooterCharacterMovement::UpdateFromCompressedFlags(uint8 Flags) {
+float UShooterCharacterMovement::GetAbilitySubstepWindowStart(float DeltaTime)
+{
+	/*Moves received by the server and client replays go through MoveAutonomous, new client moves don't*/
+	if (bMoveTimeStampValid)
+		return CurrentMoveTimeStamp - DeltaTime;
 
-	Super::UpdateFromCompressedFlags(Flags);
+	if (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_AutonomousProxy && !bClientUpdating) {
+		if (const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character())
+			return ClientData->CurrentTimeStamp - DeltaTime;
+	}
 
+	/*Without a client time stamp, a local clock is wrapped on substep boundaries*/
+	const float SubstepTime = GetAbilitySubstepTime();
+	const float Start = AbilitySubstepClock;
+	AbilitySubstepClock += DeltaTime;
+	AbilitySubstepClock -= FMath::FloorToFloat(AbilitySubstepClock / SubstepTime) * SubstepTime;
+	return Start;
+}
 
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(CharacterOwner);
-	if (!ShooterCharacter)
+void UShooterCharacterMovement::PerformSubsteppedMovement(AShooterCharacter& ShooterCharacter, float DeltaTime)
+{
+	const float SubstepTime = GetAbilitySubstepTime();
+	const float Start = GetAbilitySubstepWindowStart(DeltaTime);
+	const float End = Start + DeltaTime;
+
+	/*Boundaries within [Start - MIN_TICK_TIME, End - MIN_TICK_TIME). The move is split on each of them, and ability hooks run there,
+	* so that forces are applied at the same simulated time whatever the move duration.
+	* Boundaries are shifted back by MIN_TICK_TIME, so that the last segment is always long enough to be simulated
+	* and forces applied on a boundary are integrated by the same move. A boundary closer than that to End belongs to the next move*/
+	const int32 FirstBoundary = FMath::CeilToInt((Start - MIN_TICK_TIME) / SubstepTime);
+	const int32 EndBoundary = FMath::CeilToInt((End - MIN_TICK_TIME) / SubstepTime);
+
+	/*A boundary never carries over to the next move, that could be replayed on its own*/
+	bWallRunSubstepPending = false;
+
+	float SegmentStart = Start;
+	for (int32 Boundary = FirstBoundary; Boundary <= EndBoundary; Boundary++) {
+		const float SegmentEnd = Boundary < EndBoundary ? Boundary * SubstepTime : End;
+		const float SegmentTime = SegmentEnd - SegmentStart;
+
+		/*Only a first segment ending on a boundary shifted before Start can be too short, its time goes to the next segment*/
+		if (SegmentTime >= MIN_TICK_TIME) {
+			WallRunSubstepTimeLeft = FMath::Max(Boundary * SubstepTime - SegmentStart, SegmentTime);
+			Super::PerformMovement(SegmentTime);
+			SegmentStart = SegmentEnd;
+		}
+
+		if (Boundary == EndBoundary)
+			break;
+
+		for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++) {
+			const FShooterMovementAbilityDesc& Desc = ShooterMovementAbilities[i];
+			if (Desc.OnTick)
+				Desc.OnTick(ShooterCharacter, *this, SubstepTime);
+		}
+
+		ShooterCharacter.WallRunTick(SubstepTime);
+		bWallRunSubstepPending = true;
+	}
+}
+
+void UShooterCharacterMovement::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	/*The probe submitted last frame was cast from the position the new move starts from, so it's consumed before the move*/
+	ConsumeWallProbeAsync();
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	/*A new probe is submitted from the position the next move will start from*/
+	if (ShooterAsyncWallProbe && ShouldProbeWallAsync())
+		SubmitWallProbeAsync();
+	else
+		WallProbeResultFrame = 0;
+
+	UpdateTeleportResolutionsStat();
+}
+
+void UShooterCharacterMovement::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT_BY(STAT_ShooterTeleportResolutionsPerSecond, TeleportResolutionsLastWindow);
+	TeleportResolutionsLastWindow = 0;
+	TeleportResolutionsInWindow = 0;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UShooterCharacterMovement::UpdateTeleportResolutionsStat()
+{
+	const UWorld* World = GetWorld();
+	if (!World)
 		return;
 
-	if (ShooterCharacter->GetLocalRole() == ROLE_Authority) {
-		int8 TeleportFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringTeleport;
-		if (TeleportFlag != 0)
-			ShooterCharacter->Teleport();
+	/*The window rolls over even without any new resolution, so the stat drops back to 0 once teleports stop.
+	* The stat is the sum of the last complete window of every character*/
+	const float TimeNow = World->GetRealTimeSeconds();
+	if (TimeNow - TeleportResolutionsWindowStart < 1.f)
+		return;
 
-		int8 WallJumpFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringWallJump;
-		if (WallJumpFlag != 0)
-			ShooterCharacter->WallJump();
+	DEC_DWORD_STAT_BY(STAT_ShooterTeleportResolutionsPerSecond, TeleportResolutionsLastWindow);
+	INC_DWORD_STAT_BY(STAT_ShooterTeleportResolutionsPerSecond, TeleportResolutionsInWindow);
+	TeleportResolutionsLastWindow = TeleportResolutionsInWindow;
+	TeleportResolutionsInWindow = 0;
+	TeleportResolutionsWindowStart = TimeNow;
+}
 
-		/*Note that WallRunJuump ability shares its flags with JetpackSprint and WallRun,
-		* but they are mutually exclusive.*/
-		int8 Jetpack_WallRunJumpFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringJetpackSprint_WallRunJump;
-		int8 WallRunFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringWallRun_WallRunJump;
+void UShooterCharacterMovement::SetUpdatedComponent(USceneComponent* NewUpdatedComponent)
+{
+	Super::SetUpdatedComponent(NewUpdatedComponent);
 
-		bTriggeringJetpackSprint = (Jetpack_WallRunJumpFlag && !WallRunFlag);
+	ShooterCharacterOwner = Cast<AShooterCharacter>(CharacterOwner);
+}
 
-		if (WallRunFlag && !Jetpack_WallRunJumpFlag) {
-			ShooterCharacter->WallRunChangeState();
+void UShooterCharacterMovement::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
+{
+	CurrentMoveTimeStamp = ClientTimeStamp;
+	bMoveTimeStampValid = true;
+
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+
+	bMoveTimeStampValid = false;
+}
+
+void UShooterCharacterMovement::PerformMovement(float DeltaTime) {
+
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
+	if (ShooterCharacter) {
+		/*The same loop runs for new moves, for replayed moves and for moves received by the server*/
+		for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++) {
+			const EShooterMovementAbility Ability = (EShooterMovementAbility)i;
+			const FShooterMovementAbilityDesc& Desc = ShooterMovementAbilities[i];
+
+			if (Desc.OnTriggered && IsTriggering(Ability)) {
+				Desc.OnTriggered(*ShooterCharacter, *this);
+				if (Desc.bConsumeTrigger)
+					SetTriggering(Ability, false);
+			}
+
+			if (Desc.OnTick && !bFixedAbilitySubsteps)
+				Desc.OnTick(*ShooterCharacter, *this, DeltaTime);
 		}
-			
-			
-		if (WallRunFlag && Jetpack_WallRunJumpFlag) {
-			ShooterCharacter->WallRunJump();
-			SetWallRunJumpOnce(false);
+
+		if (bFixedAbilitySubsteps) {
+			PerformSubsteppedMovement(*ShooterCharacter, DeltaTime);
+			return;
 		}
 
+		ShooterCharacter->WallRunTick(DeltaTime);
 	}
-	else {
-		int8 TeleportFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringTeleport;
-		if (TeleportFlag != 0)
-			SetTriggeringTeleport(true);
 
+	Super::PerformMovement(DeltaTime);
 
-		int8 WallJumpFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringWallJump;
-		if (WallJumpFlag != 0)
-			SetTriggeringWallJump(true);
+}
 
-		/*Note that WallRunJuump ability shares its flags with JetpackSprint and WallRun,
-		* but they are mutually exclusive.*/
-		int8 Jetpack_WallRunJumpFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringJetpackSprint_WallRunJump;
-		int8 WallRunFlag = Flags & FSavedMove_Character_Upgraded::FLAG_TriggeringWallRun_WallRunJump;
+void UShooterCharacterMovement::UpdateFromCompressedFlags(uint8 Flags) {
+
+	Super::UpdateFromCompressedFlags(Flags);
 
-		SetTriggeringJetpackSprint(Jetpack_WallRunJumpFlag && !WallRunFlag);
 
-		if (WallRunFlag && !Jetpack_WallRunJumpFlag)
-			SetTriggeringWallRun(true);
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
+	if (!ShooterCharacter)
+		return;
 
-		if (WallRunFlag && Jetpack_WallRunJumpFlag)
-			SetTriggeringWallRunJump(true);
+	/*Client replays restore action requests in FSavedMove_Character_Upgraded::PrepMoveFor,
+	* so ability data is only needed by the server, while it's processing a move received from the client*/
+	if (ShooterCharacter->GetLocalRole() != ROLE_Authority)
+		return;
+
+	const FShooterCharacterNetworkMoveData* MoveData = static_cast<const FShooterCharacterNetworkMoveData*>(GetCurrentNetworkMoveData());
+	if (!MoveData)
+		return;
+
+	const uint8 Inputs = MoveData->AbilityInputs;
+	const uint8 OneShotMask = GetOneShotAbilityMask();
+
+	/*Held actions are applied first, so that the ability state can be compared with the client's one*/
+	for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++) {
+		const EShooterMovementAbility Ability = (EShooterMovementAbility)i;
+		if (!(OneShotMask & GetAbilityBit(Ability)))
+			SetTriggering(Ability, (Inputs & GetAbilityBit(Ability)) != 0);
+	}
+
+	bAbilityStateMismatch = MoveData->AbilityState != GetPackedAbilityState();
+	if (bAbilityStateMismatch) {
+		ReplayStats.ServerStateMismatches++;
+		INC_DWORD_STAT(STAT_ShooterServerStateMismatches);
+		CSV_CUSTOM_STAT(ShooterMovement, ServerStateMismatches, 1, ECsvCustomStatOp::Accumulate);
+	}
+	UE_CLOG(bAbilityStateMismatch, LogShooter, Verbose, TEXT("%s ability state mismatch: client 0x%02x, server 0x%02x"), *GetNameSafe(ShooterCharacter), MoveData->AbilityState, GetPackedAbilityState());
+
+	/*One-shot actions are performed once by PerformMovement, like on the client, even if the same move is received twice*/
+	if ((Inputs & OneShotMask) && CurrentMoveTimeStamp != LastOneShotTimeStamp) {
+		SetAbilityTriggers(GetAbilityTriggers() | (Inputs & OneShotMask));
+		LastOneShotTimeStamp = CurrentMoveTimeStamp;
 	}
 
-	
 }
 
 
@@ -277,118 +1067,168 @@ class FNetworkPredictionData_Client* UShooterCharacterMovement::GetPredictionDat
 }
 
 
-/**
-* These action state getters and setters also enable/disable incompatible actions
-**/
-bool UShooterCharacterMovement::GetTriggeringTeleport() const
+bool UShooterCharacterMovement::ClientUpdatePositionAfterServerUpdate()
 {
-	return bTriggeringTeleport;
-}
+	FNetworkPredictionData_Client_Character* ClientData = HasPredictionData_Client() ? GetPredictionData_Client_Character() : nullptr;
+	if (!ClientData || !ClientData->bUpdatePosition)
+		return Super::ClientUpdatePositionAfterServerUpdate();
 
-void UShooterCharacterMovement::SetTriggeringTeleport(bool bTriggeringTeleport)
-{
-	this->bTriggeringTeleport = bTriggeringTeleport;
-}
+	SCOPE_CYCLE_COUNTER(STAT_ShooterReplay);
 
-bool UShooterCharacterMovement::GetTriggeringWallJump() const
-{
-	return bTriggeringWallJump;
-}
+	/*Every saved move still waiting for an ack is replayed*/
+	const int32 MovesToReplay = ClientData->SavedMoves.Num();
+	const double ReplayStart = FPlatformTime::Seconds();
 
-void UShooterCharacterMovement::SetTriggeringWallJump(bool bTriggeringWallJump)
-{
-	this->bTriggeringWallJump = bTriggeringWallJump;
-}
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
 
-bool UShooterCharacterMovement::GetTriggeringJetpackSprint() const
-{
-	return bTriggeringJetpackSprint;
-}
+	ReplayStats.ReplaySeconds += FPlatformTime::Seconds() - ReplayStart;
+	ReplayStats.Replays++;
+	ReplayStats.ReplayedMoves += MovesToReplay;
+	INC_DWORD_STAT_BY(STAT_ShooterReplayedMoves, MovesToReplay);
+	CSV_CUSTOM_STAT(ShooterMovement, ReplayedMoves, MovesToReplay, ECsvCustomStatOp::Accumulate);
 
-void UShooterCharacterMovement::SetTriggeringJetpackSprint(bool bTriggeringJetpackSprint)
-{
-	this->bTriggeringJetpackSprint = bTriggeringJetpackSprint;
-
-	/*The player can't WallJump while JetpackSprinting*/
-	SetCanWallJump(!bTriggeringJetpackSprint);
+	return bResult;
 }
 
-bool UShooterCharacterMovement::GetTriggeringWallRun() const
+void UShooterCharacterMovement::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
 {
-	return bTriggeringWallRun && !GetTriggeringWallRunJump();
-}
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+
+	/*The corrected move has just been acknowledged*/
+	const FSavedMove_Character_Upgraded* CorrectedMove = static_cast<const FSavedMove_Character_Upgraded*>(ClientData.LastAckedMove.Get());
+	const uint8 Triggers = CorrectedMove ? CorrectedMove->SavedMove_AbilityTriggers : 0;
+
+	/*SavedLocation is updated by replays, so it's the last client result for the corrected move.
+	* Base relative locations can't be compared without the client base*/
+	if (CorrectedMove && !bBaseRelativePosition) {
+		const float Error = FVector::Dist(NewLocation, CorrectedMove->SavedLocation);
+		ReplayStats.MeasuredCorrections++;
+		ReplayStats.CorrectionErrorSum += Error;
+		ReplayStats.MaxCorrectionError = FMath::Max(ReplayStats.MaxCorrectionError, Error);
+	}
 
-void UShooterCharacterMovement::SetTriggeringWallRun(bool bTriggeringWallRun)
-{
-	this->bTriggeringWallRun = bTriggeringWallRun;
-}
+	CSV_CUSTOM_STAT(ShooterMovement, Corrections, 1, ECsvCustomStatOp::Accumulate);
+	if (!Triggers) {
+		ReplayStats.CorrectionsWithoutAbility++;
+		INC_DWORD_STAT(STAT_ShooterCorrectionsNoAbility);
+		return;
+	}
 
-bool UShooterCharacterMovement::GetTriggeringWallRunJump() const
-{
-	return bTriggeringWallRunJump;
-}
+	for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++) {
+		const EShooterMovementAbility Ability = (EShooterMovementAbility)i;
+		if (!(Triggers & GetAbilityBit(Ability)))
+			continue;
 
-void UShooterCharacterMovement::SetTriggeringWallRunJump(bool bTriggeringWallRunJump)
-{
-	this->bTriggeringWallRunJump = bTriggeringWallRunJump;
+		ReplayStats.CorrectionsPerAbility[i]++;
+		switch (Ability) {
+		case EShooterMovementAbility::Teleport: INC_DWORD_STAT(STAT_ShooterCorrectionsTeleport); break;
+		case EShooterMovementAbility::WallJump: INC_DWORD_STAT(STAT_ShooterCorrectionsWallJump); break;
+		case EShooterMovementAbility::JetpackSprint: INC_DWORD_STAT(STAT_ShooterCorrectionsJetpackSprint); break;
+		case EShooterMovementAbility::WallRun: INC_DWORD_STAT(STAT_ShooterCorrectionsWallRun); break;
+		case EShooterMovementAbility::WallRunJump: INC_DWORD_STAT(STAT_ShooterCorrectionsWallRunJump); break;
+		default: break;
+		}
+	}
 }
 
 
-
-bool UShooterCharacterMovement::GetCanTeleport() const
+const FShooterMovementAbilityDesc& UShooterCharacterMovement::GetAbilityDesc(EShooterMovementAbility Ability)
 {
-	return bCanTeleport;
+	check(Ability < EShooterMovementAbility::Count);
+	return ShooterMovementAbilities[(uint8)Ability];
 }
 
-void UShooterCharacterMovement::SetCanTeleport(bool bCanTeleport)
+uint8 UShooterCharacterMovement::GetOneShotAbilityMask()
 {
-	this->bCanTeleport = bCanTeleport;
+	static const uint8 OneShotMask = []() {
+		uint8 Mask = 0;
+		for (uint8 i = 0; i < (uint8)EShooterMovementAbility::Count; i++)
+			if (ShooterMovementAbilities[i].bConsumeTrigger)
+				Mask |= GetAbilityBit((EShooterMovementAbility)i);
+		return Mask;
+	}();
+
+	return OneShotMask;
 }
 
-bool UShooterCharacterMovement::GetCanWallJump() const
+bool UShooterCharacterMovement::IsTriggering(EShooterMovementAbility Ability) const
 {
-	return bCanWallJump;
+	return (AbilityTriggers & GetAbilityBit(Ability)) && !(AbilityTriggers & GetAbilityDesc(Ability).SuppressedByMask);
 }
 
-void UShooterCharacterMovement::SetCanWallJump(bool bCanWallJump)
+void UShooterCharacterMovement::SetTriggering(EShooterMovementAbility Ability, bool bTriggering)
 {
-	this->bCanWallJump = bCanWallJump;
+	const uint8 Bit = GetAbilityBit(Ability);
+	AbilityTriggers = bTriggering ? (AbilityTriggers | Bit) : (AbilityTriggers & ~Bit);
+
+	/*Incompatible actions are disabled while this one is triggered*/
+	const uint8 DisablesMask = GetAbilityDesc(Ability).DisablesMask;
+	if (DisablesMask)
+		AbilityAvailable = bTriggering ? (AbilityAvailable & ~DisablesMask) : (AbilityAvailable | DisablesMask);
 }
 
-bool UShooterCharacterMovement::GetCanJetpackSprint() const
+bool UShooterCharacterMovement::IsAvailable(EShooterMovementAbility Ability) const
 {
-	return bCanJetpackSprint;
+	return (AbilityAvailable & GetAbilityBit(Ability)) != 0;
 }
 
-void UShooterCharacterMovement::SetCanJetpackSprint(bool bCanJetpackSprint)
+void UShooterCharacterMovement::SetAvailable(EShooterMovementAbility Ability, bool bAvailable)
 {
-	this->bCanJetpackSprint = bCanJetpackSprint;
+	const uint8 Bit = GetAbilityBit(Ability);
+	AbilityAvailable = bAvailable ? (AbilityAvailable | Bit) : (AbilityAvailable & ~Bit);
 }
 
-bool UShooterCharacterMovement::GetCanWallRun()
+
+
+bool UShooterCharacterMovement::CanTeleport() const
 {
-	return bCanWallRun;
+	return IsAvailable(EShooterMovementAbility::Teleport);
 }
 
-void UShooterCharacterMovement::SetCanWallRun(bool bCanWallRun)
+bool UShooterCharacterMovement::ResolveTeleportDestination(const FVector& Desired, FVector& OutDestination)
 {
-	this->bCanWallRun = bCanWallRun;
-}
+	if (!CharacterOwner || !UpdatedComponent)
+		return false;
 
+	const float TimeNow = GetWorld()->GetTimeSeconds();
 
+	/*Replayed moves ask for the same destination again*/
+	if (TeleportQueryTime != 0.f && TimeNow - TeleportQueryTime < ShooterTeleportQueryCacheLifetime && TeleportQueryDesired.Equals(Desired, KINDA_SMALL_NUMBER)) {
+		INC_DWORD_STAT(STAT_ShooterTeleportCacheHits);
+		OutDestination = TeleportQueryResolved;
+		return bTeleportQueryValid;
+	}
 
-bool UShooterCharacterMovement::CanTeleport() const
-{
-	return bCanTeleport;
+	SCOPE_CYCLE_COUNTER(STAT_ShooterTeleportResolution);
+
+	/*Resolutions are counted over one second, see UpdateTeleportResolutionsStat()*/
+	TeleportResolutionsInWindow++;
+
+	TeleportQueryDesired = Desired;
+	TeleportQueryResolved = Desired;
+	TeleportQueryTime = TimeNow;
+
+	/*The destination must be obstacle free, which is the usual case, so a single capsule overlap test is enough*/
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(ShooterTeleport), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(Params, ResponseParam);
+	const FCollisionShape CapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_None);
+	const bool bEncroached = GetWorld()->OverlapBlockingTestByChannel(Desired, UpdatedComponent->GetComponentQuat(), UpdatedComponent->GetCollisionObjectType(), CapsuleShape, Params, ResponseParam);
+
+	/*Otherwise, the full encroachment search looks for an adjusted spot, just once*/
+	bTeleportQueryValid = !bEncroached || GetWorld()->FindTeleportSpot(CharacterOwner, TeleportQueryResolved, CharacterOwner->GetActorRotation());
+
+	OutDestination = TeleportQueryResolved;
+	return bTeleportQueryValid;
 }
 
 bool UShooterCharacterMovement::CanWallJump() const
 {
 	/** Two conditions are checked:
-	* first one is the boolean bCanWallJump, that can be set to false when necessary;
+	* first one is the WallJump availability bit, that can be set to false when necessary;
 	* second one is a check of the physical state of the player (is he falling, is he against a wall, etc.)*/
 
-	if (!bCanWallJump)
+	if (!IsAvailable(EShooterMovementAbility::WallJump))
 		return false;
 
 	return IsFalling() && IsWallInFrontOfPlayerValid();
@@ -396,11 +1236,11 @@ bool UShooterCharacterMovement::CanWallJump() const
 
 bool UShooterCharacterMovement::CanJetpackSprint() const
 {
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(CharacterOwner);
+	AShooterCharacter* ShooterCharacter = ShooterCharacterOwner;
 	if (!ShooterCharacter)
 		return false;
 
-	if (!bCanJetpackSprint)
+	if (!IsAvailable(EShooterMovementAbility::JetpackSprint))
 		return false;
 
 	return 0 < ShooterCharacter->GetJetpackEnergy() && !IsWallRunning();
@@ -408,7 +1248,7 @@ bool UShooterCharacterMovement::CanJetpackSprint() const
 
 bool UShooterCharacterMovement::CanWallRun(bool bSetGripPoint)
 {
-	if (!bCanWallRun)
+	if (!IsAvailable(EShooterMovementAbility::WallRun))
 		return false;
 
 	return IsFalling() && IsWallNearPlayerValid(bSetGripPoint);
@@ -469,14 +1309,19 @@ void UShooterCharacterMovement::SetWallRunFlowing(bool bWallRunFlowing)
 	this->bWallRunFlowing = bWallRunFlowing;
 }
 
-const FHitResult* UShooterCharacterMovement::GetWallRunLastHitPoint() const
+uint8 UShooterCharacterMovement::GetPackedAbilityState() const
+{
+	return FShooterCharacterNetworkMoveData::PackAbilityState(AbilityAvailable, bWallRunFlowing, bWallRunJumpOnce);
+}
+
+const FShooterWallGripPoint& UShooterCharacterMovement::GetWallRunLastGripPoint() const
 {
-	return &WallRunLastHitPoint;
+	return WallRunLastGripPoint;
 }
 
-void UShooterCharacterMovement::SetWallRunLastHitPoint(FHitResult WallRunLastHitPoint) 
+void UShooterCharacterMovement::SetWallRunLastGripPoint(const FShooterWallGripPoint& WallRunLastGripPoint)
 {
-	this->WallRunLastHitPoint = WallRunLastHitPoint;
+	this->WallRunLastGripPoint = WallRunLastGripPoint;
 }
 
 FVector UShooterCharacterMovement::GetWallRunFlowingDirection() const
@@ -514,64 +1359,40 @@ void FSavedMove_Character_Upgraded::Clear() {
 
 	FSavedMove_Character::Clear();
 
-	bSavedMove_TriggeringTeleport = false;
-	bSavedMove_TriggeringWallJump = false;
-	bSavedMove_TriggeringJetpackSprint = false;
-	bSavedMove_TriggeringWallRun = false;
-	bSavedMove_TriggeringWallRunJump = false;
-
-	bSavedMove_CanTeleport = true;
-	bSavedMove_CanWallJump = true;
-	bSavedMove_CanJetpackSprint = true;
-	bSavedMove_CanWallRun = true;
+	SavedMove_AbilityTriggers = 0;
+	SavedMove_AbilityAvailable = (uint8)((1 << (uint8)EShooterMovementAbility::Count) - 1);
 }
 
-uint8 FSavedMove_Character_Upgraded::GetCompressedFlags() const {
-
-	uint8 Flags = FSavedMove_Character::GetCompressedFlags();
-
-	if (bSavedMove_TriggeringTeleport)
-		Flags |= FLAG_TriggeringTeleport;
-
-	if (bSavedMove_TriggeringWallJump)
-		Flags |= FLAG_TriggeringWallJump;
-
-	if (bSavedMove_TriggeringJetpackSprint || bSavedMove_TriggeringWallRunJump)
-		Flags |= FLAG_TriggeringJetpackSprint_WallRunJump;
-
-	if (bSavedMove_TriggeringWallRun || bSavedMove_TriggeringWallRunJump)
-		Flags |= FLAG_TriggeringWallRun_WallRunJump;
-		
+uint8 FSavedMove_Character_Upgraded::GetAbilityInputs() const
+{
+	/*AbilityInputFlags match EShooterMovementAbility bits*/
+	return SavedMove_AbilityTriggers;
+}
 
-	return Flags;
+uint8 FSavedMove_Character_Upgraded::GetAbilityState() const
+{
+	return FShooterCharacterNetworkMoveData::PackAbilityState(SavedMove_AbilityAvailable, bSavedMove_bWallRunFlowing, bSavedMove_WallRunJumpOnce);
 }
 
 void FSavedMove_Character_Upgraded::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData)
 {
 	FSavedMove_Character::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
 
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(Character);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(Character->GetCharacterMovement());
+	/*Upgraded saved moves are only allocated by UShooterCharacterMovement, so no dynamic cast is needed*/
+	UShooterCharacterMovement* CharMov = static_cast<UShooterCharacterMovement*>(Character->GetCharacterMovement());
+	AShooterCharacter* ShooterCharacter = CharMov ? CharMov->GetShooterCharacterOwner() : nullptr;
 	if (!ShooterCharacter || !CharMov)
 		return;
 
-	bSavedMove_TriggeringTeleport = CharMov->GetTriggeringTeleport();
-	bSavedMove_TriggeringWallJump = CharMov->GetTriggeringWallJump();
-	bSavedMove_TriggeringJetpackSprint = CharMov->GetTriggeringJetpackSprint();
-	bSavedMove_TriggeringWallRun = CharMov->GetTriggeringWallRun();
-	bSavedMove_TriggeringWallRunJump = CharMov->GetTriggeringWallRunJump();
-
-	bSavedMove_CanTeleport = CharMov->GetCanTeleport();
-	bSavedMove_CanWallJump = CharMov->GetCanWallJump();
-	bSavedMove_CanJetpackSprint = CharMov->GetCanJetpackSprint();
-	bSavedMove_CanWallRun = CharMov->GetCanWallRun();
+	SavedMove_AbilityTriggers = CharMov->GetAbilityTriggers();
+	SavedMove_AbilityAvailable = CharMov->GetAbilityAvailable();
 
 	SavedMove_JetpackEnergy = ShooterCharacter->GetJetpackEnergy();
 	SavedMove_WallRunMaxEndingTime = CharMov->GetWallRunMaxEndingTime();
 	SavedMove_WallRunMaxJumpTime = CharMov->GetWallRunMaxJumpTime();
 	bSavedMove_WallRunJumpOnce = CharMov->GetWallRunJumpOnce();
 	bSavedMove_bWallRunFlowing = CharMov->GetWallRunFlowing();
-	SavedMove_WallRunLastHitPoint = *CharMov->GetWallRunLastHitPoint();
+	SavedMove_WallRunLastGripPoint = CharMov->GetWallRunLastGripPoint();
 	SavedMove_WallRunFlowingDirection = CharMov->GetWallRunFlowingDirection();
 }
 
@@ -579,28 +1400,85 @@ void FSavedMove_Character_Upgraded::PrepMoveFor(class ACharacter* Character)
 {
 	FSavedMove_Character::PrepMoveFor(Character);
 
-	AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(Character);
-	UShooterCharacterMovement* CharMov = Cast<UShooterCharacterMovement>(Character->GetCharacterMovement());
+	/*Upgraded saved moves are only allocated by UShooterCharacterMovement, so no dynamic cast is needed*/
+	UShooterCharacterMovement* CharMov = static_cast<UShooterCharacterMovement*>(Character->GetCharacterMovement());
+	AShooterCharacter* ShooterCharacter = CharMov ? CharMov->GetShooterCharacterOwner() : nullptr;
 	if (!ShooterCharacter || !CharMov)
 		return;
 
-	CharMov->SetTriggeringTeleport(bSavedMove_TriggeringTeleport);
-	CharMov->SetTriggeringWallJump(bSavedMove_TriggeringWallJump);
-	CharMov->SetTriggeringJetpackSprint(bSavedMove_TriggeringJetpackSprint);
-	CharMov->SetTriggeringWallRun(bSavedMove_TriggeringWallRun);
-	CharMov->SetTriggeringWallRunJump(bSavedMove_TriggeringWallRunJump);
+	/*Availability side effects of triggers aren't applied: availability is restored as it was saved*/
+	CharMov->SetAbilityTriggers(SavedMove_AbilityTriggers);
+
+	RestoreAbilityStateFor(ShooterCharacter, CharMov);
+}
+
+bool FSavedMove_Character_Upgraded::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
+{
+	const FSavedMove_Character_Upgraded* LastAckedUpgradedMove = static_cast<const FSavedMove_Character_Upgraded*>(LastAckedMove.Get());
+	if (GetAbilityInputs() != LastAckedUpgradedMove->GetAbilityInputs())
+		return true;
+
+	return FSavedMove_Character::IsImportantMove(LastAckedMove);
+}
 
-	CharMov->SetCanTeleport(bSavedMove_CanTeleport);
-	CharMov->SetCanWallJump(bSavedMove_CanWallJump);
-	CharMov->SetCanJetpackSprint(bSavedMove_CanJetpackSprint);
-	CharMov->SetCanWallRun(bSavedMove_CanWallRun);
+bool FSavedMove_Character_Upgraded::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Character_Upgraded* NewUpgradedMove = static_cast<const FSavedMove_Character_Upgraded*>(NewMove.Get());
+
+	/*One-shot actions must reach the server in their own move*/
+	if ((SavedMove_AbilityTriggers | NewUpgradedMove->SavedMove_AbilityTriggers) & UShooterCharacterMovement::GetOneShotAbilityMask())
+		return false;
+
+	/*Held actions and action availability must not change between the two moves*/
+	if (SavedMove_AbilityTriggers != NewUpgradedMove->SavedMove_AbilityTriggers || SavedMove_AbilityAvailable != NewUpgradedMove->SavedMove_AbilityAvailable)
+		return false;
+
+	/**
+	* WallRun timers are only set on state changes, so they must be the same.
+	* JetpackEnergy isn't compared: it changes at a constant rate and it's simply
+	* integrated over the combined DeltaTime.
+	*/
+	if (bSavedMove_bWallRunFlowing != NewUpgradedMove->bSavedMove_bWallRunFlowing || bSavedMove_WallRunJumpOnce != NewUpgradedMove->bSavedMove_WallRunJumpOnce)
+		return false;
+	if (SavedMove_WallRunMaxEndingTime != NewUpgradedMove->SavedMove_WallRunMaxEndingTime || SavedMove_WallRunMaxJumpTime != NewUpgradedMove->SavedMove_WallRunMaxJumpTime)
+		return false;
+
+	/*While flowing along a wall, the direction must be steady too*/
+	if (bSavedMove_bWallRunFlowing && !SavedMove_WallRunFlowingDirection.Equals(NewUpgradedMove->SavedMove_WallRunFlowingDirection, 0.02f))
+		return false;
+
+	return FSavedMove_Character::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Character_Upgraded::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	FSavedMove_Character::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	/*Upgraded saved moves are only allocated by UShooterCharacterMovement, so no dynamic cast is needed*/
+	UShooterCharacterMovement* CharMov = static_cast<UShooterCharacterMovement*>(InCharacter->GetCharacterMovement());
+	AShooterCharacter* ShooterCharacter = CharMov ? CharMov->GetShooterCharacterOwner() : nullptr;
+	if (!ShooterCharacter || !CharMov)
+		return;
+
+	/*This move now starts where OldMove started, so its stored ability state is the old one*/
+	const FSavedMove_Character_Upgraded* OldUpgradedMove = static_cast<const FSavedMove_Character_Upgraded*>(OldMove);
+	SavedMove_JetpackEnergy = OldUpgradedMove->SavedMove_JetpackEnergy;
+	SavedMove_WallRunLastGripPoint = OldUpgradedMove->SavedMove_WallRunLastGripPoint;
+	SavedMove_WallRunFlowingDirection = OldUpgradedMove->SavedMove_WallRunFlowingDirection;
+
+	RestoreAbilityStateFor(ShooterCharacter, CharMov);
+}
+
+void FSavedMove_Character_Upgraded::RestoreAbilityStateFor(AShooterCharacter* ShooterCharacter, UShooterCharacterMovement* CharMov) const
+{
+	CharMov->SetAbilityAvailable(SavedMove_AbilityAvailable);
 
 	ShooterCharacter->SetJetpackEnergy(SavedMove_JetpackEnergy);
 	CharMov->SetWallRunMaxEndingTime(SavedMove_WallRunMaxEndingTime);
 	CharMov->SetWallRunMaxJumpTime(SavedMove_WallRunMaxJumpTime);
 	CharMov->SetWallRunJumpOnce(bSavedMove_WallRunJumpOnce);
 	CharMov->SetWallRunFlowing(bSavedMove_bWallRunFlowing);
-	CharMov->SetWallRunLastHitPoint(SavedMove_WallRunLastHitPoint);
+	CharMov->SetWallRunLastGripPoint(SavedMove_WallRunLastGripPoint);
 	CharMov->SetWallRunFlowingDirection(SavedMove_WallRunFlowingDirection);
 }
 
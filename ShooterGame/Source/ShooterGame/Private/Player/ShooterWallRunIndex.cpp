@@ -0,0 +1,382 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Player/ShooterWallRunIndex.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+static int32 ShooterWallRunIndexEnabled = 1;
+FAutoConsoleVariableRef CVarShooterWallRunIndex(
+	TEXT("p.ShooterWallRunIndex"),
+	ShooterWallRunIndexEnabled,
+	TEXT("WallRun grip point detection against the static walls index.\n")
+	TEXT("0: scene traces only, 1: static walls index, with scene traces for movable bodies and not indexed geometry"),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Wall index build"), STAT_ShooterWallIndexBuild, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wall index queries"), STAT_ShooterWallIndexQueries, STATGROUP_ShooterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wall index fallbacks"), STAT_ShooterWallIndexFallbacks, STATGROUP_ShooterMovement);
+
+/*Grid cell size, WallRun rays are much shorter than this*/
+static const float WallIndexCellSize = 512.f;
+
+void UShooterWallRunIndex::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bBuilt = false;
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UShooterWallRunIndex::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UShooterWallRunIndex::OnLevelRemoved);
+}
+
+void UShooterWallRunIndex::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	Invalidate();
+
+	Super::Deinitialize();
+}
+
+void UShooterWallRunIndex::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Before the match starts, so that the build never hitches a WallRun
+	if (InWorld.IsGameWorld())
+	{
+		Build();
+	}
+}
+
+void UShooterWallRunIndex::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	// Levels added before BeginPlay are part of the first build
+	if (World == GetWorld() && bBuilt && Level)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		int32 NumIndexedComponents = 0;
+		int32 NumUnindexedComponents = 0;
+		AddLevel(Level, NumIndexedComponents, NumUnindexedComponents);
+
+		UE_LOG(LogShooter, Log, TEXT("WallRun index for %s: added %d colliders from %s, %d colliders not indexed, in %.2f ms"),
+			*GetWorld()->GetMapName(), NumIndexedComponents, *Level->GetOuter()->GetName(), NumUnindexedComponents, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+}
+
+void UShooterWallRunIndex::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	// Grid cells don't track their levels: rebuild from the remaining ones, while streaming hitches anyway
+	if (World == GetWorld() && bBuilt)
+	{
+		Build();
+	}
+}
+
+void UShooterWallRunIndex::Invalidate()
+{
+	Segments.Reset();
+	Cells.Reset();
+	bBuilt = false;
+}
+
+bool UShooterWallRunIndex::RaycastStatic(UWorld* World, const FVector& Start, const FVector& End, FHitResult& OutHit)
+{
+	UShooterWallRunIndex* Index = (ShooterWallRunIndexEnabled && World && World->IsGameWorld()) ? World->GetSubsystem<UShooterWallRunIndex>() : nullptr;
+	if (!Index || !Index->bBuilt)
+	{
+		return false;
+	}
+
+	OutHit = FHitResult();
+	bool bUnindexed = false;
+	Index->Raycast(Start, End, OutHit, bUnindexed);
+
+	if (bUnindexed)
+	{
+		INC_DWORD_STAT(STAT_ShooterWallIndexFallbacks);
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_ShooterWallIndexQueries);
+	return true;
+}
+
+bool UShooterWallRunIndex::LineTraceWall(UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params)
+{
+	FHitResult StaticHit;
+	if (RaycastStatic(World, Start, End, StaticHit))
+	{
+		// Static walls are indexed, so only movable bodies (pawns, physics props...) still need a scene query, up to the static hit
+		FCollisionQueryParams DynamicParams(Params);
+		DynamicParams.MobilityType = EQueryMobilityType::Dynamic;
+		const FVector DynamicEnd = StaticHit.bBlockingHit ? StaticHit.Location : End;
+
+		UShooterCharacterMovement::CountWallTraces(1);
+		if (World->LineTraceSingleByChannel(OutHit, Start, DynamicEnd, ECC_Pawn, DynamicParams))
+		{
+			OutHit.Time = OutHit.Distance / FMath::Max((End - Start).Size(), KINDA_SMALL_NUMBER);
+			OutHit.TraceEnd = End;
+			return true;
+		}
+
+		if (StaticHit.bBlockingHit)
+		{
+			OutHit = StaticHit;
+		}
+		return StaticHit.bBlockingHit;
+	}
+
+	UShooterCharacterMovement::CountWallTraces(1);
+	return World->LineTraceSingleByChannel(OutHit, Start, End, ECC_Pawn, Params);
+}
+
+FIntPoint UShooterWallRunIndex::GetCell(const FVector& Location)
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / WallIndexCellSize), FMath::FloorToInt(Location.Y / WallIndexCellSize));
+}
+
+void UShooterWallRunIndex::Build()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterWallIndexBuild);
+	const double StartTime = FPlatformTime::Seconds();
+
+	Invalidate();
+
+	int32 NumIndexedComponents = 0;
+	int32 NumUnindexedComponents = 0;
+
+	for (ULevel* Level : GetWorld()->GetLevels())
+	{
+		if (Level && Level->bIsVisible)
+		{
+			AddLevel(Level, NumIndexedComponents, NumUnindexedComponents);
+		}
+	}
+
+	bBuilt = true;
+
+	UE_LOG(LogShooter, Log, TEXT("WallRun index for %s: %d wall faces from %d colliders, %d colliders not indexed, %d cells, built in %.2f ms"),
+		*GetWorld()->GetMapName(), Segments.Num(), NumIndexedComponents, NumUnindexedComponents, Cells.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void UShooterWallRunIndex::AddLevel(ULevel* Level, int32& OutNumIndexedComponents, int32& OutNumUnindexedComponents)
+{
+	TInlineComponentArray<UPrimitiveComponent*> Components;
+	for (AActor* Actor : Level->Actors)
+	{
+		if (!Actor)
+		{
+			continue;
+		}
+
+		Actor->GetComponents(Components);
+		for (UPrimitiveComponent* Component : Components)
+		{
+			// Only static bodies are skipped by the dynamic scene query, and only blocking ones stop wall traces
+			if (!Component->IsRegistered() || Component->Mobility == EComponentMobility::Movable
+				|| !Component->IsQueryCollisionEnabled() || Component->GetCollisionResponseToChannel(ECC_Pawn) != ECR_Block)
+			{
+				continue;
+			}
+
+			if (AddComponent(Component))
+			{
+				OutNumIndexedComponents++;
+			}
+			else
+			{
+				MarkUnindexed(Component->Bounds.GetBox());
+				OutNumUnindexedComponents++;
+			}
+		}
+	}
+}
+
+bool UShooterWallRunIndex::AddComponent(UPrimitiveComponent* Component)
+{
+	const UBodySetup* BodySetup = Component->GetBodySetup();
+	if (!BodySetup || BodySetup->CollisionTraceFlag == CTF_UseComplexAsSimple)
+	{
+		return false;
+	}
+
+	// Instances (HISM, foliage...) share the body setup, each at its own transform
+	UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Component);
+	if (InstancedComponent)
+	{
+		const int32 NumInstances = InstancedComponent->GetInstanceCount();
+		for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; InstanceIndex++)
+		{
+			FTransform InstanceTM;
+			if (InstancedComponent->GetInstanceTransform(InstanceIndex, InstanceTM, true) && !AddBody(Component, BodySetup, InstanceTM, InstanceIndex))
+			{
+				MarkUnindexed(BodySetup->AggGeom.CalcAABB(InstanceTM));
+			}
+		}
+		return true;
+	}
+
+	return AddBody(Component, BodySetup, Component->GetComponentTransform(), INDEX_NONE);
+}
+
+bool UShooterWallRunIndex::AddBody(UPrimitiveComponent* Component, const UBodySetup* BodySetup, const FTransform& BodyTM, int32 Item)
+{
+	// Only upright boxes are indexed, any other shape falls back to scene traces
+	const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+	if (AggGeom.BoxElems.Num() == 0 || AggGeom.SphereElems.Num() > 0 || AggGeom.SphylElems.Num() > 0 || AggGeom.ConvexElems.Num() > 0 || AggGeom.TaperedCapsuleElems.Num() > 0)
+	{
+		return false;
+	}
+
+	for (const FKBoxElem& BoxElem : AggGeom.BoxElems)
+	{
+		const FTransform BoxTM = BoxElem.GetTransform() * BodyTM;
+		if (FMath::Abs(BoxTM.TransformVectorNoScale(FVector::UpVector).Z) < 0.99f)
+		{
+			return false;
+		}
+	}
+
+	for (const FKBoxElem& BoxElem : AggGeom.BoxElems)
+	{
+		const FTransform BoxTM = BoxElem.GetTransform() * BodyTM;
+		const FVector HalfExtent(BoxElem.X * 0.5f, BoxElem.Y * 0.5f, BoxElem.Z * 0.5f);
+
+		AddBoxFace(Component, Item, BoxTM, FVector::ForwardVector, FVector::RightVector, HalfExtent);
+		AddBoxFace(Component, Item, BoxTM, -FVector::ForwardVector, FVector::RightVector, HalfExtent);
+		AddBoxFace(Component, Item, BoxTM, FVector::RightVector, FVector::ForwardVector, HalfExtent);
+		AddBoxFace(Component, Item, BoxTM, -FVector::RightVector, FVector::ForwardVector, HalfExtent);
+	}
+
+	return true;
+}
+
+void UShooterWallRunIndex::AddBoxFace(UPrimitiveComponent* Component, int32 Item, const FTransform& BoxTM, const FVector& LocalNormal, const FVector& LocalTangent, const FVector& HalfExtent)
+{
+	FShooterWallSegment Segment;
+	Segment.Center = BoxTM.TransformPosition(LocalNormal * HalfExtent);
+	Segment.Normal = (Segment.Center - BoxTM.GetLocation()).GetSafeNormal();
+	const FVector TangentExtent = BoxTM.TransformVector(LocalTangent * HalfExtent);
+	Segment.HalfLength = TangentExtent.Size();
+	Segment.Tangent = TangentExtent.GetSafeNormal();
+	Segment.HalfHeight = BoxTM.TransformVector(FVector(0.f, 0.f, HalfExtent.Z)).Size();
+	Segment.Component = Component;
+	Segment.Item = Item;
+
+	if (Segment.Normal.IsNearlyZero() || Segment.HalfLength <= KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	const int32 SegmentIndex = Segments.Add(Segment);
+
+	const FVector FaceEnd = Segment.Tangent * Segment.HalfLength;
+	const FIntPoint MinCell = GetCell((Segment.Center - FaceEnd).ComponentMin(Segment.Center + FaceEnd));
+	const FIntPoint MaxCell = GetCell((Segment.Center - FaceEnd).ComponentMax(Segment.Center + FaceEnd));
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			Cells.FindOrAdd(FIntPoint(X, Y)).SegmentIndices.Add(SegmentIndex);
+		}
+	}
+}
+
+void UShooterWallRunIndex::MarkUnindexed(const FBox& Bounds)
+{
+	const FIntPoint MinCell = GetCell(Bounds.Min);
+	const FIntPoint MaxCell = GetCell(Bounds.Max);
+
+	// Large colliders, like landscapes, mark many cells: WallRun queries around them keep using scene traces
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			Cells.FindOrAdd(FIntPoint(X, Y)).bHasUnindexedGeometry = true;
+		}
+	}
+}
+
+bool UShooterWallRunIndex::Raycast(const FVector& Start, const FVector& End, FHitResult& OutHit, bool& bOutUnindexed) const
+{
+	bOutUnindexed = false;
+
+	const FVector Delta = End - Start;
+	const FIntPoint MinCell = GetCell(Start.ComponentMin(End));
+	const FIntPoint MaxCell = GetCell(Start.ComponentMax(End));
+
+	float BestTime = 2.f;
+	int32 BestIndex = INDEX_NONE;
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const FCell* Cell = Cells.Find(FIntPoint(X, Y));
+			if (!Cell)
+			{
+				continue;
+			}
+
+			if (Cell->bHasUnindexedGeometry)
+			{
+				bOutUnindexed = true;
+				return false;
+			}
+
+			for (int32 SegmentIndex : Cell->SegmentIndices)
+			{
+				const FShooterWallSegment& Segment = Segments[SegmentIndex];
+
+				// Like scene traces, back faces are never hit
+				const float Approach = Delta | Segment.Normal;
+				if (Approach >= 0.f)
+				{
+					continue;
+				}
+
+				const float Time = ((Segment.Center - Start) | Segment.Normal) / Approach;
+				if (Time < 0.f || Time > 1.f || Time >= BestTime)
+				{
+					continue;
+				}
+
+				const FVector Local = Start + Delta * Time - Segment.Center;
+				if (FMath::Abs(Local | Segment.Tangent) > Segment.HalfLength || FMath::Abs(Local.Z) > Segment.HalfHeight)
+				{
+					continue;
+				}
+
+				BestTime = Time;
+				BestIndex = SegmentIndex;
+			}
+		}
+	}
+
+	if (BestIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FShooterWallSegment& Segment = Segments[BestIndex];
+	UPrimitiveComponent* Component = Segment.Component.Get();
+	if (!Component)
+	{
+		// Indexed geometry is gone without a level change: the index is stale
+		bOutUnindexed = true;
+		return false;
+	}
+
+	OutHit = FHitResult(Start, End);
+	OutHit.bBlockingHit = true;
+	OutHit.Time = BestTime;
+	OutHit.Distance = Delta.Size() * BestTime;
+	OutHit.Location = OutHit.ImpactPoint = Start + Delta * BestTime;
+	OutHit.Normal = OutHit.ImpactNormal = Segment.Normal;
+	OutHit.Component = Component;
+	OutHit.Actor = Component->GetOwner();
+	OutHit.Item = Segment.Item;
+
+	return true;
+}
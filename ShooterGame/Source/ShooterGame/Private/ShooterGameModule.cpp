@@ -15,12 +15,17 @@
 
 
 #include "UI/Style/ShooterStyle.h"
+#include "Tests/ShooterBenchmarkMallocCounter.h"
 
 
 class FShooterGameModule : public FDefaultGameModuleImpl
 {
 	virtual void StartupModule() override
 	{
+#if WITH_SHOOTER_MALLOC_COUNTER
+		// Before any game code runs, for the movement benchmark only
+		FShooterBenchmarkMallocCounter::InstallIfRequested();
+#endif
 		InitializeShooterGameDelegates();
 		FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry"));
 
@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#include "Tests/ShooterBenchmarkMallocCounter.h"
+#include "ShooterGame.h"
+
+#if WITH_SHOOTER_MALLOC_COUNTER
+
+FShooterBenchmarkMallocCounter* FShooterBenchmarkMallocCounter::Instance = nullptr;
+
+FShooterBenchmarkMallocCounter::FShooterBenchmarkMallocCounter(FMalloc* InUsedMalloc)
+	: UsedMalloc(InUsedMalloc)
+	, bCounting(false)
+	, NumAllocations(0)
+	, AllocatedBytes(0)
+{
+}
+
+void FShooterBenchmarkMallocCounter::InstallIfRequested()
+{
+	if (Instance || !FParse::Param(FCommandLine::Get(), TEXT("BenchmarkMallocCounter")))
+	{
+		return;
+	}
+
+	// Blocks allocated before the swap are freed through the proxy, which forwards them to the same allocator
+	Instance = new FShooterBenchmarkMallocCounter(GMalloc);
+	FPlatformMisc::MemoryBarrier();
+	GMalloc = Instance;
+
+	UE_LOG(LogShooter, Log, TEXT("Benchmark allocation counter installed over %s"), Instance->UsedMalloc->GetDescriptiveName());
+}
+
+#endif // WITH_SHOOTER_MALLOC_COUNTER
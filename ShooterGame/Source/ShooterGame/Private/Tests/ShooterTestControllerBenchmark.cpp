@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#include "Tests/ShooterTestControllerBenchmark.h"
+#include "ShooterGame.h"
+#include "GameFramework/PlayerStart.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+void UShooterTestControllerBenchmark::InitOutputPath(const TCHAR* Param, const TCHAR* DefaultFileName)
+{
+	OutputPath = FPaths::ProjectSavedDir() / TEXT("Automation") / DefaultFileName;
+	ParseSetting(Param, OutputPath);
+}
+
+AShooterGameMode* UShooterTestControllerBenchmark::GetReadyGameMode() const
+{
+	UWorld* World = GetWorld();
+	AShooterGameMode* GameMode = World ? World->GetAuthGameMode<AShooterGameMode>() : nullptr;
+	if (!GameMode || !World->HasBegunPlay() || !GameMode->BotPawnClass)
+	{
+		return nullptr;
+	}
+
+	return GameMode;
+}
+
+bool UShooterTestControllerBenchmark::GetPlayerStarts(TArray<APlayerStart*>& OutPlayerStarts)
+{
+	UWorld* World = GetWorld();
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		OutPlayerStarts.Add(*It);
+	}
+
+	if (OutPlayerStarts.Num() == 0)
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  No PlayerStart to spawn bots in %s"), *World->GetMapName());
+		EndTest(-1);
+		return false;
+	}
+
+	return true;
+}
+
+AShooterCharacter* UShooterTestControllerBenchmark::SpawnBot(AShooterGameMode* GameMode, const FVector& Location, const FRotator& Rotation, TSubclassOf<AController> ControllerClass)
+{
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	AShooterCharacter* Pawn = GetWorld()->SpawnActor<AShooterCharacter>(GameMode->BotPawnClass, Location, Rotation, SpawnInfo);
+	if (!Pawn || !Pawn->GetShooterCharacterMovement())
+	{
+		return nullptr;
+	}
+
+	Pawn->AIControllerClass = ControllerClass;
+	Pawn->SpawnDefaultController();
+	return Pawn;
+}
+
+void UShooterTestControllerBenchmark::WriteReportAndEndTest(const TSharedRef<FJsonObject>& Report, const TCHAR* ReportName, bool bSuccess)
+{
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	UE_LOG(LogGauntlet, Display, TEXT("%s results: %s"), ReportName, *Json);
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  Could not write %s results to %s"), ReportName, *OutputPath);
+		EndTest(-1);
+		return;
+	}
+
+	EndTest(bSuccess ? 0 : -1);
+}
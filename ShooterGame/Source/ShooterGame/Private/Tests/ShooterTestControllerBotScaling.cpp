@@ -0,0 +1,188 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#include "Tests/ShooterTestControllerBotScaling.h"
+#include "ShooterGame.h"
+#include "Bots/ShooterAIController.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "GameFramework/PlayerStart.h"
+
+void UShooterTestControllerBotScaling::OnInit()
+{
+	FString BotCountsParam = TEXT("10,25,50,100");
+	FramesPerMode = 60;
+
+	ParseSetting(TEXT("BenchmarkBotCounts="), BotCountsParam);
+	ParseSetting(TEXT("BenchmarkFrames="), FramesPerMode);
+	InitOutputPath(TEXT("BenchmarkOutput="), TEXT("BotScalingBenchmark.json"));
+
+	// the visibility cache hides traces behind async results, keep it off unless asked to measure both
+	bUseVisibilityCache = FParse::Param(FCommandLine::Get(), TEXT("BenchmarkVisibilityCache"));
+
+	TArray<FString> BotCountStrings;
+	BotCountsParam.ParseIntoArray(BotCountStrings, TEXT(","));
+	for (const FString& BotCountString : BotCountStrings)
+	{
+		BotCounts.Add(FMath::Max(FCString::Atoi(*BotCountString), 1));
+	}
+
+	StepIndex = 0;
+	StepFrame = 0;
+	QueryMs[0] = QueryMs[1] = 0.0;
+	Traces[0] = Traces[1] = 0;
+	Frames[0] = Frames[1] = 0;
+}
+
+void UShooterTestControllerBotScaling::OnTick(float TimeDelta)
+{
+	if (StepIndex >= BotCounts.Num())
+	{
+		return;
+	}
+
+	if (Bots.Num() < BotCounts[StepIndex])
+	{
+		if (!SpawnBots(BotCounts[StepIndex]))
+		{
+			return;
+		}
+
+		// let new bots land before measuring
+		StepFrame = -30;
+	}
+
+	StepFrame++;
+	if (StepFrame <= 0)
+	{
+		return;
+	}
+
+	// alternate frames, so that both modes see the same bot positions
+	const int32 Mode = StepFrame % 2;
+	const uint64 TracesAtStart = AShooterAIController::GetWeaponLOSTraceCount();
+	QueryMs[Mode] += RunQueries(Mode == 1);
+	Traces[Mode] += AShooterAIController::GetWeaponLOSTraceCount() - TracesAtStart;
+	Frames[Mode]++;
+
+	if (StepFrame >= FramesPerMode * 2)
+	{
+		FinishStep();
+
+		StepIndex++;
+		if (StepIndex >= BotCounts.Num())
+		{
+			FinishBenchmark();
+		}
+	}
+}
+
+bool UShooterTestControllerBotScaling::SpawnBots(int32 Count)
+{
+	AShooterGameMode* GameMode = GetReadyGameMode();
+	if (!GameMode)
+	{
+		return false;
+	}
+
+	TArray<APlayerStart*> PlayerStarts;
+	if (!GetPlayerStarts(PlayerStarts))
+	{
+		return false;
+	}
+
+	for (int32 i = Bots.Num(); i < Count; i++)
+	{
+		// spread bots around player starts, so that they end up in different cells
+		const APlayerStart* PlayerStart = PlayerStarts[i % PlayerStarts.Num()];
+		const float Angle = 2.0f * PI * (i / PlayerStarts.Num()) / 8.0f;
+		const FVector Location = PlayerStart->GetActorLocation() + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * 150.0f * (1 + i / (PlayerStarts.Num() * 8));
+		AShooterCharacter* Pawn = SpawnBot(GameMode, Location, PlayerStart->GetActorRotation(), AShooterAIController::StaticClass());
+		AShooterAIController* Bot = Pawn ? Cast<AShooterAIController>(Pawn->Controller) : nullptr;
+		if (Bot)
+		{
+			// only target acquisition is measured
+			Bot->GetBehaviorComp()->StopTree();
+			Bots.Add(Bot);
+		}
+	}
+
+	UE_LOG(LogGauntlet, Display, TEXT("Bot scaling benchmark: %d bots in %s"), Bots.Num(), *GetWorld()->GetMapName());
+
+	if (Bots.Num() < Count)
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  Could only spawn %d of %d benchmark bots"), Bots.Num(), Count);
+		EndTest(-1);
+		return false;
+	}
+
+	return true;
+}
+
+double UShooterTestControllerBotScaling::RunQueries(bool bUseIndex)
+{
+	// both settings are only changed while queries run, and previous values are restored right after
+	IConsoleVariable* EnemyIndexCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("p.ShooterEnemyIndex"));
+	const int32 EnemyIndexAtStart = EnemyIndexCVar ? EnemyIndexCVar->GetInt() : 0;
+	if (EnemyIndexCVar)
+	{
+		EnemyIndexCVar->Set(bUseIndex ? 1 : 0);
+	}
+
+	IConsoleVariable* VisibilityCacheCVar = bUseVisibilityCache ? nullptr : IConsoleManager::Get().FindConsoleVariable(TEXT("p.ShooterVisibilityCache"));
+	const int32 VisibilityCacheAtStart = VisibilityCacheCVar ? VisibilityCacheCVar->GetInt() : 0;
+	if (VisibilityCacheCVar)
+	{
+		VisibilityCacheCVar->Set(0);
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (AShooterAIController* Bot : Bots)
+	{
+		if (Bot && Bot->GetPawn())
+		{
+			Bot->FindClosestEnemy();
+			Bot->FindClosestEnemyWithLOS(nullptr);
+		}
+	}
+
+	const uint64 EndCycles = FPlatformTime::Cycles64();
+
+	if (EnemyIndexCVar)
+	{
+		EnemyIndexCVar->Set(EnemyIndexAtStart);
+	}
+	if (VisibilityCacheCVar)
+	{
+		VisibilityCacheCVar->Set(VisibilityCacheAtStart);
+	}
+
+	return FPlatformTime::ToMilliseconds64(EndCycles - StartCycles);
+}
+
+void UShooterTestControllerBotScaling::FinishStep()
+{
+	TSharedRef<FJsonObject> Step = MakeShared<FJsonObject>();
+	Step->SetNumberField(TEXT("Bots"), Bots.Num());
+	Step->SetNumberField(TEXT("Frames"), Frames[0] + Frames[1]);
+	Step->SetNumberField(TEXT("LinearMsPerFrame"), Frames[0] ? QueryMs[0] / Frames[0] : 0.0);
+	Step->SetNumberField(TEXT("IndexMsPerFrame"), Frames[1] ? QueryMs[1] / Frames[1] : 0.0);
+	Step->SetNumberField(TEXT("LinearTracesPerFrame"), Frames[0] ? (double)Traces[0] / Frames[0] : 0.0);
+	Step->SetNumberField(TEXT("IndexTracesPerFrame"), Frames[1] ? (double)Traces[1] / Frames[1] : 0.0);
+	StepResults.Add(MakeShared<FJsonValueObject>(Step));
+
+	UE_LOG(LogGauntlet, Display, TEXT("Bot scaling benchmark: %d bots, linear %.3f ms, index %.3f ms per frame"),
+		Bots.Num(), Frames[0] ? QueryMs[0] / Frames[0] : 0.0, Frames[1] ? QueryMs[1] / Frames[1] : 0.0);
+
+	QueryMs[0] = QueryMs[1] = 0.0;
+	Traces[0] = Traces[1] = 0;
+	Frames[0] = Frames[1] = 0;
+}
+
+void UShooterTestControllerBotScaling::FinishBenchmark()
+{
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("Map"), GetWorld() ? GetWorld()->GetMapName() : FString());
+	Report->SetNumberField(TEXT("FramesPerMode"), FramesPerMode);
+	Report->SetArrayField(TEXT("Steps"), StepResults);
+
+	WriteReportAndEndTest(Report, TEXT("Bot scaling benchmark"));
+}
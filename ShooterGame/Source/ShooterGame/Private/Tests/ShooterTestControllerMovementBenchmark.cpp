@@ -0,0 +1,240 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#include "Tests/ShooterTestControllerMovementBenchmark.h"
+#include "Tests/ShooterBenchmarkMallocCounter.h"
+#include "ShooterGame.h"
+#include "AIController.h"
+#include "GameFramework/PlayerStart.h"
+
+void UShooterTestControllerMovementBenchmark::OnInit()
+{
+	NumPawns = 32;
+	WarmupSeconds = 5.0f;
+	BenchmarkSeconds = 30.0f;
+
+	ParseSetting(TEXT("BenchmarkPawns="), NumPawns);
+	ParseSetting(TEXT("BenchmarkWarmup="), WarmupSeconds);
+	ParseSetting(TEXT("BenchmarkSeconds="), BenchmarkSeconds);
+	InitOutputPath(TEXT("BenchmarkOutput="), TEXT("MovementBenchmark.json"));
+
+	ElapsedSeconds = 0.0;
+	bMeasuring = false;
+	WallTracesAtStart = 0;
+	UsedPhysicalAtStart = 0;
+	AllocationsAtStart = 0;
+	AllocatedBytesAtStart = 0;
+
+#if WITH_SHOOTER_MALLOC_COUNTER
+	if (!FShooterBenchmarkMallocCounter::Get())
+#endif
+	{
+		UE_LOG(LogGauntlet, Warning, TEXT("Movement benchmark: allocations are not counted, run a non-shipping build with -BenchmarkMallocCounter"));
+	}
+}
+
+void UShooterTestControllerMovementBenchmark::OnTick(float TimeDelta)
+{
+	if (Pawns.Num() == 0)
+	{
+		if (!SpawnPawns())
+		{
+			return;
+		}
+	}
+
+	ElapsedSeconds += TimeDelta;
+
+	ScriptPawns(TimeDelta);
+	const double MovementMs = TickPawnsMovement(TimeDelta);
+
+	if (!bMeasuring && ElapsedSeconds >= WarmupSeconds)
+	{
+		bMeasuring = true;
+		WallTracesAtStart = UShooterCharacterMovement::GetWallTraceCount();
+		UsedPhysicalAtStart = FPlatformMemory::GetStats().UsedPhysical;
+#if WITH_SHOOTER_MALLOC_COUNTER
+		if (FShooterBenchmarkMallocCounter* MallocCounter = FShooterBenchmarkMallocCounter::Get())
+		{
+			AllocationsAtStart = MallocCounter->GetNumAllocations();
+			AllocatedBytesAtStart = MallocCounter->GetAllocatedBytes();
+		}
+#endif
+		return;
+	}
+
+	if (bMeasuring)
+	{
+		FrameMovementMs.Add(MovementMs);
+
+		if (ElapsedSeconds >= WarmupSeconds + BenchmarkSeconds)
+		{
+			FinishBenchmark();
+		}
+	}
+}
+
+bool UShooterTestControllerMovementBenchmark::SpawnPawns()
+{
+	AShooterGameMode* GameMode = GetReadyGameMode();
+	if (!GameMode)
+	{
+		return false;
+	}
+
+	TArray<APlayerStart*> PlayerStarts;
+	if (!GetPlayerStarts(PlayerStarts))
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < NumPawns; i++)
+	{
+		const APlayerStart* PlayerStart = PlayerStarts[i % PlayerStarts.Num()];
+		const FVector Location = PlayerStart->GetActorLocation() + FVector(0.0f, 0.0f, 100.0f * (i / PlayerStarts.Num()));
+
+		// A plain AIController provides the control rotation, without any behavior tree moving the pawn
+		AShooterCharacter* Pawn = SpawnBot(GameMode, Location, PlayerStart->GetActorRotation(), AAIController::StaticClass());
+		if (!Pawn)
+		{
+			continue;
+		}
+
+		if (Pawn->Controller)
+		{
+			Pawn->Controller->SetControlRotation(FRotator(0.0f, 360.0f * i / NumPawns, 0.0f));
+		}
+
+		Pawn->GetShooterCharacterMovement()->SetComponentTickEnabled(false);
+		Pawns.Add(Pawn);
+	}
+
+	UE_LOG(LogGauntlet, Display, TEXT("Movement benchmark: %d pawns spawned in %s"), Pawns.Num(), *GetWorld()->GetMapName());
+
+	if (Pawns.Num() == 0)
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  Could not spawn any benchmark pawn"));
+		EndTest(-1);
+		return false;
+	}
+
+	return true;
+}
+
+void UShooterTestControllerMovementBenchmark::ScriptPawns(float TimeDelta)
+{
+	// Each pawn performs one step per second, with a different phase:
+	// Teleport, JetpackSprint start, JetpackSprint stop and WallJump, WallRun start/stop
+	for (int32 i = 0; i < Pawns.Num(); i++)
+	{
+		AShooterCharacter* Pawn = Pawns[i];
+		UShooterCharacterMovement* CharMov = Pawn ? Pawn->GetShooterCharacterMovement() : nullptr;
+		if (!CharMov || !Pawn->Controller)
+		{
+			continue;
+		}
+
+		const double PawnTime = ElapsedSeconds + (double)i / Pawns.Num();
+		const int32 Step = FMath::FloorToInt(PawnTime);
+		const int32 PrevStep = FMath::FloorToInt(PawnTime - TimeDelta);
+
+		FRotator ControlRotation = Pawn->Controller->GetControlRotation();
+		ControlRotation.Yaw += 45.0f * TimeDelta;
+		Pawn->Controller->SetControlRotation(ControlRotation);
+		Pawn->AddMovementInput(ControlRotation.Vector());
+
+		if (Step == PrevStep)
+		{
+			continue;
+		}
+
+		switch (Step % 4)
+		{
+		case 0:
+			CharMov->SetTriggering(EShooterMovementAbility::Teleport, true);
+			break;
+		case 1:
+			CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, true);
+			break;
+		case 2:
+			CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, false);
+			CharMov->SetTriggering(EShooterMovementAbility::WallJump, true);
+			break;
+		default:
+			CharMov->SetTriggering(CharMov->CanWallRunJump() ? EShooterMovementAbility::WallRunJump : EShooterMovementAbility::WallRun, true);
+			break;
+		}
+	}
+}
+
+double UShooterTestControllerMovementBenchmark::TickPawnsMovement(float TimeDelta)
+{
+#if WITH_SHOOTER_MALLOC_COUNTER
+	FShooterBenchmarkMallocCounter* MallocCounter = FShooterBenchmarkMallocCounter::Get();
+	if (MallocCounter)
+	{
+		MallocCounter->SetCounting(true);
+	}
+#endif
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (AShooterCharacter* Pawn : Pawns)
+	{
+		UShooterCharacterMovement* CharMov = Pawn ? Pawn->GetShooterCharacterMovement() : nullptr;
+		if (CharMov)
+		{
+			CharMov->TickComponent(TimeDelta, LEVELTICK_All, &CharMov->PrimaryComponentTick);
+		}
+	}
+
+	const uint64 EndCycles = FPlatformTime::Cycles64();
+#if WITH_SHOOTER_MALLOC_COUNTER
+	if (MallocCounter)
+	{
+		MallocCounter->SetCounting(false);
+	}
+#endif
+
+	return FPlatformTime::ToMilliseconds64(EndCycles - StartCycles);
+}
+
+void UShooterTestControllerMovementBenchmark::FinishBenchmark()
+{
+	TArray<double> SortedMs = FrameMovementMs;
+	SortedMs.Sort();
+
+	double TotalMs = 0.0;
+	for (double Ms : SortedMs)
+	{
+		TotalMs += Ms;
+	}
+
+	const int32 NumFrames = FMath::Max(SortedMs.Num(), 1);
+	const uint64 WallTraces = UShooterCharacterMovement::GetWallTraceCount() - WallTracesAtStart;
+	const int64 UsedPhysicalDelta = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)UsedPhysicalAtStart;
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("Map"), GetWorld() ? GetWorld()->GetMapName() : FString());
+	Report->SetNumberField(TEXT("Pawns"), Pawns.Num());
+	Report->SetNumberField(TEXT("Frames"), SortedMs.Num());
+	Report->SetNumberField(TEXT("Seconds"), BenchmarkSeconds);
+	Report->SetNumberField(TEXT("MovementMsAvg"), TotalMs / NumFrames);
+	Report->SetNumberField(TEXT("MovementMsMedian"), SortedMs.Num() ? SortedMs[SortedMs.Num() / 2] : 0.0);
+	Report->SetNumberField(TEXT("MovementMsP95"), SortedMs.Num() ? SortedMs[FMath::Min(SortedMs.Num() - 1, SortedMs.Num() * 95 / 100)] : 0.0);
+	Report->SetNumberField(TEXT("MovementMsMax"), SortedMs.Num() ? SortedMs.Last() : 0.0);
+	Report->SetNumberField(TEXT("MovementUsPerPawn"), Pawns.Num() ? TotalMs * 1000.0 / NumFrames / Pawns.Num() : 0.0);
+	Report->SetNumberField(TEXT("WallTracesPerFrame"), (double)WallTraces / NumFrames);
+#if WITH_SHOOTER_MALLOC_COUNTER
+	// Left out when the counter isn't installed, rather than reported as 0
+	if (const FShooterBenchmarkMallocCounter* MallocCounter = FShooterBenchmarkMallocCounter::Get())
+	{
+		const uint64 Allocations = MallocCounter->GetNumAllocations() - AllocationsAtStart;
+		const uint64 AllocatedBytes = MallocCounter->GetAllocatedBytes() - AllocatedBytesAtStart;
+		Report->SetNumberField(TEXT("AllocationsPerFrame"), (double)Allocations / NumFrames);
+		Report->SetNumberField(TEXT("AllocatedBytesPerFrame"), (double)AllocatedBytes / NumFrames);
+		Report->SetNumberField(TEXT("AllocationsPerPawnTick"), Pawns.Num() ? (double)Allocations / NumFrames / Pawns.Num() : 0.0);
+	}
+#endif
+	// Process wide working set change over the whole run, it's not an allocation count
+	Report->SetNumberField(TEXT("UsedPhysicalDeltaBytes"), (double)UsedPhysicalDelta);
+
+	WriteReportAndEndTest(Report, TEXT("Movement benchmark"));
+}
@@ -0,0 +1,214 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#include "Tests/ShooterTestControllerMovementDeterminism.h"
+#include "ShooterGame.h"
+
+// Script steps last half a second
+static const float DeterminismStepSeconds = 0.5f;
+// JetpackSprint state during each script step, repeated
+static const bool DeterminismJetpackScript[] = { true, true, false, true, false, false };
+// Time for the server to switch the pawn to fixed substeps before the first phase
+static const float DeterminismSettleSeconds = 1.0f;
+
+void UShooterTestControllerMovementDeterminism::OnInit()
+{
+	NumSteps = 8;
+	Tolerance = 1.0f;
+	TimeoutSeconds = 120.0f;
+
+	ParseSetting(TEXT("DeterminismSteps="), NumSteps);
+	ParseSetting(TEXT("DeterminismTolerance="), Tolerance);
+	ParseSetting(TEXT("DeterminismTimeout="), TimeoutSeconds);
+	InitOutputPath(TEXT("DeterminismOutput="), TEXT("MovementDeterminism.json"));
+
+	Pawn = nullptr;
+	PhaseIndex = -1;
+	Step = 0;
+	NextStepTime = 0.0f;
+	WaitSeconds = 0.0f;
+	Jitter.Initialize(NumSteps);
+
+	IConsoleVariable* MaxFPS = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"));
+	MaxFPSAtStart = MaxFPS ? MaxFPS->GetFloat() : 0.0f;
+
+	const int32 FrameRates[] = { 60, 30, 20, 0 };
+	for (int32 FrameRate : FrameRates)
+	{
+		FDeterminismPhase& Phase = Phases.AddDefaulted_GetRef();
+		Phase.FrameRate = FrameRate;
+		Phase.Name = FrameRate ? FString::Printf(TEXT("%dHz"), FrameRate) : TEXT("Jitter");
+		Phase.MeasuredCorrections = 0;
+		Phase.MaxCorrectionError = 0.0f;
+		Phase.AvgCorrectionError = 0.0f;
+	}
+
+	if (IsRunningDedicatedServer())
+	{
+		// Every client move the server checks is corrected, so that every one of them is compared
+		if (IConsoleVariable* ForceAdjustment = IConsoleManager::Get().FindConsoleVariable(TEXT("p.NetForceClientAdjustmentPercent")))
+		{
+			ForceAdjustment->Set(1.0f);
+		}
+		else
+		{
+			UE_LOG(LogGauntlet, Warning, TEXT("p.NetForceClientAdjustmentPercent is not available, only diverging moves will be compared"));
+		}
+	}
+}
+
+void UShooterTestControllerMovementDeterminism::OnTick(float TimeDelta)
+{
+	if (IsRunningDedicatedServer())
+	{
+		TickServer();
+		return;
+	}
+
+	// The test has already ended
+	if (PhaseIndex >= Phases.Num())
+	{
+		return;
+	}
+
+	if (!Pawn)
+	{
+		if (FindPawn(TimeDelta))
+		{
+			NextStepTime = GetWorld()->GetTimeSeconds() + DeterminismSettleSeconds;
+		}
+		return;
+	}
+
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	UShooterCharacterMovement* CharMov = Pawn->GetShooterCharacterMovement();
+	if (Pawn->IsPendingKill() || !CharMov || !PC || PC->GetPawn() != Pawn)
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  The determinism pawn was lost during phase %d"), PhaseIndex);
+		PhaseIndex = Phases.Num();
+		EndTest(-1);
+		return;
+	}
+
+	if (Phases.IsValidIndex(PhaseIndex) && Phases[PhaseIndex].FrameRate == 0)
+	{
+		IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"))->Set(Jitter.FRandRange(15.0f, 60.0f));
+	}
+
+	if (GetWorld()->GetTimeSeconds() < NextStepTime)
+	{
+		return;
+	}
+	NextStepTime += DeterminismStepSeconds;
+
+	if (PhaseIndex < 0 || ++Step >= NumSteps)
+	{
+		StartPhase(PhaseIndex + 1);
+		if (PhaseIndex >= Phases.Num())
+		{
+			return;
+		}
+	}
+
+	CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, DeterminismJetpackScript[Step % UE_ARRAY_COUNT(DeterminismJetpackScript)]);
+}
+
+void UShooterTestControllerMovementDeterminism::TickServer()
+{
+	// Players may join at any time, and client and server must integrate their abilities the same way
+	for (TActorIterator<AShooterCharacter> It(GetWorld()); It; ++It)
+	{
+		UShooterCharacterMovement* CharMov = It->GetShooterCharacterMovement();
+		if (CharMov && It->IsPlayerControlled())
+		{
+			CharMov->bFixedAbilitySubsteps = true;
+		}
+	}
+}
+
+bool UShooterTestControllerMovementDeterminism::FindPawn(float TimeDelta)
+{
+	APlayerController* PC = GetWorld() ? GetWorld()->GetFirstPlayerController() : nullptr;
+	AShooterCharacter* PossessedPawn = PC ? Cast<AShooterCharacter>(PC->GetPawn()) : nullptr;
+	if (!PossessedPawn || PossessedPawn->GetLocalRole() != ROLE_AutonomousProxy || !PossessedPawn->GetShooterCharacterMovement())
+	{
+		WaitSeconds += TimeDelta;
+		if (WaitSeconds > TimeoutSeconds)
+		{
+			UE_LOG(LogGauntlet, Error, TEXT("Failed!  No autonomous pawn was possessed after %.0f seconds, the client must be connected to a server"), WaitSeconds);
+			PhaseIndex = Phases.Num();
+			EndTest(-1);
+		}
+		return false;
+	}
+
+	Pawn = PossessedPawn;
+	Pawn->GetShooterCharacterMovement()->bFixedAbilitySubsteps = true;
+	return true;
+}
+
+void UShooterTestControllerMovementDeterminism::StartPhase(int32 NewPhaseIndex)
+{
+	UShooterCharacterMovement* CharMov = Pawn->GetShooterCharacterMovement();
+
+	if (Phases.IsValidIndex(PhaseIndex))
+	{
+		const FShooterMovementReplayStats& Stats = CharMov->GetReplayStats();
+		FDeterminismPhase& Phase = Phases[PhaseIndex];
+		Phase.MeasuredCorrections = Stats.MeasuredCorrections;
+		Phase.MaxCorrectionError = Stats.MaxCorrectionError;
+		Phase.AvgCorrectionError = Stats.MeasuredCorrections ? (float)(Stats.CorrectionErrorSum / Stats.MeasuredCorrections) : 0.0f;
+	}
+
+	PhaseIndex = NewPhaseIndex;
+	Step = 0;
+
+	if (PhaseIndex >= Phases.Num())
+	{
+		CharMov->SetTriggering(EShooterMovementAbility::JetpackSprint, false);
+		IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"))->Set(MaxFPSAtStart);
+		FinishTest();
+		return;
+	}
+
+	IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"))->Set((float)Phases[PhaseIndex].FrameRate);
+	CharMov->ResetReplayStats();
+}
+
+void UShooterTestControllerMovementDeterminism::FinishTest()
+{
+	TArray<TSharedPtr<FJsonValue>> Results;
+	float MaxError = 0.0f;
+	bool bMissingCorrections = false;
+
+	for (const FDeterminismPhase& Phase : Phases)
+	{
+		MaxError = FMath::Max(MaxError, Phase.MaxCorrectionError);
+		bMissingCorrections |= Phase.MeasuredCorrections == 0;
+
+		UE_LOG(LogGauntlet, Display, TEXT("Movement determinism %s: %u corrections, server vs client error max %.3f cm, avg %.3f cm"),
+			*Phase.Name, Phase.MeasuredCorrections, Phase.MaxCorrectionError, Phase.AvgCorrectionError);
+
+		TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetStringField(TEXT("Phase"), Phase.Name);
+		Result->SetNumberField(TEXT("Corrections"), Phase.MeasuredCorrections);
+		Result->SetNumberField(TEXT("MaxLocationError"), Phase.MaxCorrectionError);
+		Result->SetNumberField(TEXT("AvgLocationError"), Phase.AvgCorrectionError);
+		Results.Add(MakeShared<FJsonValueObject>(Result));
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("Map"), GetWorld() ? GetWorld()->GetMapName() : FString());
+	Report->SetNumberField(TEXT("Steps"), NumSteps);
+	Report->SetNumberField(TEXT("Tolerance"), Tolerance);
+	Report->SetArrayField(TEXT("Results"), Results);
+
+	if (bMissingCorrections)
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  No server correction was received during a phase, nothing was compared"));
+	}
+	else if (MaxError > Tolerance)
+	{
+		UE_LOG(LogGauntlet, Error, TEXT("Failed!  Client and server diverge by %.3f cm with fixed ability substeps (tolerance %.3f cm)"), MaxError, Tolerance);
+	}
+
+	WriteReportAndEndTest(Report, TEXT("Movement determinism"), !bMissingCorrections && MaxError <= Tolerance);
+}
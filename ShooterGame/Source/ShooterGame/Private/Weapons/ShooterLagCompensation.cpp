@@ -0,0 +1,378 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Weapons/ShooterLagCompensation.h"
+#include "Weapons/ShooterWeapon_Instant.h"
+
+static float ShooterRewindMaxTime = 0.5f;
+FAutoConsoleVariableRef CVarShooterRewindMaxTime(
+	TEXT("p.ShooterRewindMaxTime"),
+	ShooterRewindMaxTime,
+	TEXT("Maximum time, in seconds, client hits can be rewound to.\n")
+	TEXT("Hits fired further in the past are checked against the oldest recorded hitbox."),
+	ECVF_Default);
+
+static float ShooterRewindSampleInterval = 1.0f / 60.0f;
+FAutoConsoleVariableRef CVarShooterRewindSampleInterval(
+	TEXT("p.ShooterRewindSampleInterval"),
+	ShooterRewindSampleInterval,
+	TEXT("Minimum time, in seconds, between two recorded hitbox samples.\n")
+	TEXT("Together with p.ShooterRewindMaxTime, it bounds the memory used per character."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Rewind record"), STAT_ShooterRewindRecord, STATGROUP_ShooterWeapon);
+DECLARE_CYCLE_STAT(TEXT("Rewind hit validation"), STAT_ShooterRewindValidation, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rewound hits"), STAT_ShooterRewoundHits, STATGROUP_ShooterWeapon);
+DECLARE_CYCLE_STAT(TEXT("Batched hit validation"), STAT_ShooterBatchedValidation, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit validation targets"), STAT_ShooterValidationTargets, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Validated hits/s"), STAT_ShooterValidatedHitsPerSecond, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Rejected hits/s"), STAT_ShooterRejectedHitsPerSecond, STATGROUP_ShooterWeapon);
+
+FAutoConsoleCommandWithWorldAndArgs ShooterRewindBenchmarkCmd(TEXT("ShooterWeapon.BenchmarkRewind"), TEXT("Measures the cost of rewind hit validation per shot, immediate and batched, over the recorded characters. Usage: ShooterWeapon.BenchmarkRewind [Shots=10000]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+{
+	UShooterLagCompensation* LagCompensation = World ? World->GetSubsystem<UShooterLagCompensation>() : nullptr;
+
+	TArray<AShooterCharacter*> ShooterCharacters;
+	for (AShooterCharacter* ShooterCharacter : TActorRange<AShooterCharacter>(World))
+	{
+		const FShooterRewindHistory* History = LagCompensation ? LagCompensation->FindHistory(ShooterCharacter) : nullptr;
+		if (History && History->Num > 0)
+		{
+			ShooterCharacters.Add(ShooterCharacter);
+		}
+	}
+
+	if (ShooterCharacters.Num() == 0)
+	{
+		UE_LOG(LogShooterWeapon, Warning, TEXT("ShooterWeapon.BenchmarkRewind: no recorded character, run it on a server with players"));
+		return;
+	}
+
+	const int32 Shots = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+	FRandomStream RandomStream(Shots);
+
+	// shots hit the rewound location of a character, at a random time within its history.
+	// Automatic weapons fire many shots per frame at the same targets: shot times are shared by a few shots
+	TArray<FShooterPendingHit> Hits;
+	Hits.Reserve(Shots);
+	for (int32 i = 0; i < Shots; i++)
+	{
+		AShooterCharacter* ShooterCharacter = ShooterCharacters[i % ShooterCharacters.Num()];
+		const FShooterRewindHistory* History = LagCompensation->FindHistory(ShooterCharacter);
+		const FShooterRewindSample& Sample = History->GetSample(RandomStream.RandHelper(History->Num));
+
+		FShooterPendingHit& Hit = Hits.AddDefaulted_GetRef();
+		Hit.Impact = FHitResult(ShooterCharacter, nullptr, Sample.Location, FVector::UpVector);
+		Hit.ShotTime = Sample.Time;
+		Hit.Leeway = 1.0f;
+	}
+
+	int32 Confirmed = 0;
+	const double ImmediateStart = FPlatformTime::Seconds();
+	for (const FShooterPendingHit& Hit : Hits)
+	{
+		Confirmed += LagCompensation->ValidateHit(Hit.Impact, Hit.ShotTime, Hit.Leeway) ? 1 : 0;
+	}
+	const double ImmediateSeconds = FPlatformTime::Seconds() - ImmediateStart;
+
+	// pending hits of the current frame are validated first, so that they aren't measured
+	LagCompensation->ValidatePendingHits();
+	const double BatchedStart = FPlatformTime::Seconds();
+	for (FShooterPendingHit& Hit : Hits)
+	{
+		LagCompensation->QueueHit(MoveTemp(Hit));
+	}
+	const int32 BatchedConfirmed = LagCompensation->ValidatePendingHits();
+	const double BatchedSeconds = FPlatformTime::Seconds() - BatchedStart;
+
+	UE_LOG(LogShooterWeapon, Display, TEXT("%d shots over %d characters: immediate %.1f ns/shot (%d confirmed), batched %.1f ns/shot (%d confirmed). Histories: %d samples max, %d bytes total"),
+		Shots, ShooterCharacters.Num(), ImmediateSeconds * 1e9 / Shots, Confirmed, BatchedSeconds * 1e9 / Shots, BatchedConfirmed,
+		UShooterLagCompensation::GetHistoryCapacity(), (int32)LagCompensation->GetAllocatedSize());
+}));
+
+//////////////////////////////////////////////////////////////////////////
+// FShooterRewindHistory
+
+void FShooterRewindHistory::Add(float Time, const FVector& Location)
+{
+	check(Samples.Num() > 0);
+
+	Head = (Head + 1) % Samples.Num();
+	Num = FMath::Min(Num + 1, Samples.Num());
+
+	Samples[Head].Time = Time;
+	Samples[Head].Location = Location;
+}
+
+bool FShooterRewindHistory::GetLocationAt(float Time, FVector& OutLocation) const
+{
+	if (Num == 0)
+	{
+		return false;
+	}
+
+	// shots are usually recent: search from the newest sample
+	const FShooterRewindSample* Newer = &GetSample(0);
+	if (Time >= Newer->Time)
+	{
+		OutLocation = Newer->Location;
+		return true;
+	}
+
+	for (int32 Index = 1; Index < Num; Index++)
+	{
+		const FShooterRewindSample& Older = GetSample(Index);
+		if (Time >= Older.Time)
+		{
+			const float Alpha = (Time - Older.Time) / FMath::Max(Newer->Time - Older.Time, KINDA_SMALL_NUMBER);
+			OutLocation = FMath::Lerp(Older.Location, Newer->Location, Alpha);
+			return true;
+		}
+		Newer = &Older;
+	}
+
+	// older than the history: use the oldest sample
+	OutLocation = Newer->Location;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UShooterLagCompensation
+
+void UShooterLagCompensation::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LastSampleTime = -BIG_NUMBER;
+	NumValidatedHits = 0;
+	NumRejectedHits = 0;
+	ThroughputWindowStart = FPlatformTime::Seconds();
+	ValidatedHitsAtWindowStart = 0;
+	RejectedHitsAtWindowStart = 0;
+}
+
+void UShooterLagCompensation::Deinitialize()
+{
+	Histories.Empty();
+	PendingHits.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UShooterLagCompensation::IsTickable() const
+{
+	// only servers validate client hits
+	const UWorld* World = GetWorld();
+	return World && World->IsGameWorld() && (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer);
+}
+
+TStatId UShooterLagCompensation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterLagCompensation, STATGROUP_Tickables);
+}
+
+void UShooterLagCompensation::Tick(float DeltaTime)
+{
+	// hits received this frame are validated against the history recorded so far
+	ValidatePendingHits();
+
+	RecordHistories();
+
+	// throughput over the last second
+	const double PlatformTimeNow = FPlatformTime::Seconds();
+	if (1.0 <= PlatformTimeNow - ThroughputWindowStart)
+	{
+		SET_DWORD_STAT(STAT_ShooterValidatedHitsPerSecond, NumValidatedHits - ValidatedHitsAtWindowStart);
+		SET_DWORD_STAT(STAT_ShooterRejectedHitsPerSecond, NumRejectedHits - RejectedHitsAtWindowStart);
+		ThroughputWindowStart = PlatformTimeNow;
+		ValidatedHitsAtWindowStart = NumValidatedHits;
+		RejectedHitsAtWindowStart = NumRejectedHits;
+	}
+}
+
+void UShooterLagCompensation::RecordHistories()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterRewindRecord);
+
+	UWorld* World = GetWorld();
+	const float Now = World->GetTimeSeconds();
+	if (Now - LastSampleTime < ShooterRewindSampleInterval)
+	{
+		return;
+	}
+	LastSampleTime = Now;
+
+	const int32 Capacity = GetHistoryCapacity();
+
+	for (auto It = Histories.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (AShooterCharacter* ShooterCharacter : TActorRange<AShooterCharacter>(World))
+	{
+		FShooterRewindHistory& History = Histories.FindOrAdd(ShooterCharacter);
+
+		// capacity changes only when tweaking cvars: drop the history instead of resampling it
+		if (History.Samples.Num() != Capacity)
+		{
+			History = FShooterRewindHistory();
+			History.Samples.SetNumUninitialized(Capacity);
+		}
+
+		History.Add(Now, ShooterCharacter->GetActorLocation());
+	}
+}
+
+bool UShooterLagCompensation::ValidateHit(const FHitResult& Impact, float ShotTime, float Leeway) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterRewindValidation);
+
+	const AActor* HitActor = Impact.GetActor();
+	if (!HitActor)
+	{
+		return false;
+	}
+
+	// Get the component bounding box
+	FBox HitBox = HitActor->GetComponentsBoundingBox();
+
+	// move it where the actor was when the client fired, shots can't be rewound further than p.ShooterRewindMaxTime
+	const FShooterRewindHistory* History = FindHistory(HitActor);
+	FVector RewoundLocation;
+	if (History && History->GetLocationAt(FMath::Max(ShotTime, GetWorld()->GetTimeSeconds() - ShooterRewindMaxTime), RewoundLocation))
+	{
+		HitBox = HitBox.ShiftBy(RewoundLocation - HitActor->GetActorLocation());
+		INC_DWORD_STAT(STAT_ShooterRewoundHits);
+	}
+
+	return IsWithinHitBox(HitBox, Impact.Location, Leeway);
+}
+
+void UShooterLagCompensation::QueueHit(FShooterPendingHit&& Hit)
+{
+	PendingHits.Add(MoveTemp(Hit));
+}
+
+int32 UShooterLagCompensation::ValidatePendingHits()
+{
+	if (PendingHits.Num() == 0)
+	{
+		return 0;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterBatchedValidation);
+
+	// group by target, then by shot time, so that shared work is done once
+	PendingHits.Sort([](const FShooterPendingHit& A, const FShooterPendingHit& B)
+	{
+		const AActor* ActorA = A.Impact.GetActor();
+		const AActor* ActorB = B.Impact.GetActor();
+		return ActorA != ActorB ? ActorA < ActorB : A.ShotTime < B.ShotTime;
+	});
+
+	const float OldestShotTime = GetWorld()->GetTimeSeconds() - ShooterRewindMaxTime;
+	const AActor* Target = nullptr;
+	const FShooterRewindHistory* History = nullptr;
+	FBox CurrentBox(ForceInit);
+	FVector CurrentLocation = FVector::ZeroVector;
+	float RewoundTime = 0.0f;
+	FBox RewoundBox(ForceInit);
+	int32 NumConfirmed = 0;
+
+	for (int32 Index = 0; Index < PendingHits.Num(); Index++)
+	{
+		const FShooterPendingHit& Hit = PendingHits[Index];
+		const AActor* HitActor = Hit.Impact.GetActor();
+
+		bool bConfirmed = false;
+		if (HitActor)
+		{
+			// new target: bounding box and history are fetched once for all its hits
+			if (HitActor != Target)
+			{
+				Target = HitActor;
+				History = FindHistory(Target);
+				CurrentBox = Target->GetComponentsBoundingBox();
+				CurrentLocation = Target->GetActorLocation();
+				RewoundBox = CurrentBox;
+				RewoundTime = -BIG_NUMBER;
+				INC_DWORD_STAT(STAT_ShooterValidationTargets);
+			}
+
+			// new shot time: rewind the box, shots fired at the same time share it
+			const float ShotTime = FMath::Max(Hit.ShotTime, OldestShotTime);
+			FVector RewoundLocation;
+			if (History && ShotTime != RewoundTime && History->GetLocationAt(ShotTime, RewoundLocation))
+			{
+				RewoundTime = ShotTime;
+				RewoundBox = CurrentBox.ShiftBy(RewoundLocation - CurrentLocation);
+				INC_DWORD_STAT(STAT_ShooterRewoundHits);
+			}
+
+			bConfirmed = IsWithinHitBox(RewoundBox, Hit.Impact.Location, Hit.Leeway);
+		}
+
+		if (bConfirmed)
+		{
+			NumValidatedHits++;
+			NumConfirmed++;
+		}
+		else
+		{
+			NumRejectedHits++;
+		}
+
+		if (AShooterWeapon_Instant* Weapon = Hit.Weapon.Get())
+		{
+			Weapon->OnHitValidated(Hit, bConfirmed);
+		}
+	}
+
+	PendingHits.Reset();
+	return NumConfirmed;
+}
+
+bool UShooterLagCompensation::IsWithinHitBox(const FBox& HitBox, const FVector& Location, float Leeway)
+{
+	// calculate the box extent, and increase by a leeway
+	FVector BoxExtent = 0.5 * (HitBox.Max - HitBox.Min);
+	BoxExtent *= Leeway;
+
+	// avoid precision errors with really thin objects
+	BoxExtent.X = FMath::Max(20.0f, BoxExtent.X);
+	BoxExtent.Y = FMath::Max(20.0f, BoxExtent.Y);
+	BoxExtent.Z = FMath::Max(20.0f, BoxExtent.Z);
+
+	// Get the box center
+	const FVector BoxCenter = (HitBox.Min + HitBox.Max) * 0.5;
+
+	// is it within client tolerance?
+	return FMath::Abs(Location.Z - BoxCenter.Z) < BoxExtent.Z &&
+		FMath::Abs(Location.X - BoxCenter.X) < BoxExtent.X &&
+		FMath::Abs(Location.Y - BoxCenter.Y) < BoxExtent.Y;
+}
+
+const FShooterRewindHistory* UShooterLagCompensation::FindHistory(const AActor* Actor) const
+{
+	return Histories.Find(Actor);
+}
+
+SIZE_T UShooterLagCompensation::GetAllocatedSize() const
+{
+	SIZE_T Size = Histories.GetAllocatedSize();
+	for (const auto& Pair : Histories)
+	{
+		Size += Pair.Value.Samples.GetAllocatedSize();
+	}
+	return Size;
+}
+
+int32 UShooterLagCompensation::GetHistoryCapacity()
+{
+	return FMath::Max(2, FMath::CeilToInt(ShooterRewindMaxTime / FMath::Max(ShooterRewindSampleInterval, KINDA_SMALL_NUMBER)) + 1);
+}
@@ -4,6 +4,7 @@
 #include "Weapons/ShooterProjectile.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Effects/ShooterExplosionEffect.h"
+#include "Weapons/ShooterProjectilePool.h"
 
 AShooterProjectile::AShooterProjectile(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -37,6 +38,7 @@ AShooterProjectile::AShooterProjectile(const FObjectInitializer& ObjectInitializ
 	SetRemoteRoleForBackwardsCompat(ROLE_SimulatedProxy);
 	bReplicates = true;
 	SetReplicatingMovement(true);
+	bPooled = false;
 }
 
 void AShooterProjectile::PostInitializeComponents()
@@ -51,8 +53,111 @@ void AShooterProjectile::PostInitializeComponents()
 		OwnerWeapon->ApplyWeaponConfig(WeaponConfig);
 	}
 
-	SetLifeSpan( WeaponConfig.ProjectileLife );
+	SetProjectileLife( WeaponConfig.ProjectileLife );
 	MyController = GetInstigatorController();
+
+	if (bPooled)
+	{
+		PoolState.bActive = true;
+	}
+}
+
+void AShooterProjectile::Reactivate(const FTransform& SpawnTM, FVector& ShootDirection)
+{
+	GetWorldTimerManager().ClearTimer(TimerHandle_ReturnToPool);
+
+	SetNetDormancy(DORM_Awake);
+	SetActorTransform(SpawnTM, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	CollisionComp->MoveIgnoreActors.Reset();
+	CollisionComp->MoveIgnoreActors.Add(GetInstigator());
+
+	AShooterWeapon_Projectile* OwnerWeapon = Cast<AShooterWeapon_Projectile>(GetOwner());
+	if (OwnerWeapon)
+	{
+		OwnerWeapon->ApplyWeaponConfig(WeaponConfig);
+	}
+	MyController = GetInstigatorController();
+	bExploded = false;
+	PoolState.Generation++;
+	PoolState.bActive = true;
+
+	ResetComponents();
+	InitVelocity(ShootDirection);
+
+	SetProjectileLife( WeaponConfig.ProjectileLife );
+	ForceNetUpdate();
+}
+
+void AShooterProjectile::Deactivate()
+{
+	GetWorldTimerManager().ClearTimer(TimerHandle_ReturnToPool);
+
+	MovementComp->StopMovementImmediately();
+	StopComponents();
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	PoolState.bActive = false;
+
+	// nothing changes until the pool reuses it, clients get the parked state before the channel goes dormant
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void AShooterProjectile::SetProjectileLife(float Seconds)
+{
+	if (bPooled)
+	{
+		GetWorldTimerManager().SetTimer(TimerHandle_ReturnToPool, this, &AShooterProjectile::ReturnToPool, Seconds, false);
+	}
+	else
+	{
+		SetLifeSpan(Seconds);
+	}
+}
+
+void AShooterProjectile::ReturnToPool()
+{
+	UShooterProjectilePool* ProjectilePool = GetWorld()->GetSubsystem<UShooterProjectilePool>();
+	if (ProjectilePool)
+	{
+		ProjectilePool->Release(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void AShooterProjectile::ResetComponents()
+{
+	MovementComp->SetUpdatedComponent(CollisionComp);
+
+	for (UActorComponent* Component : GetComponents())
+	{
+		if (Component && Component->bAutoActivate)
+		{
+			Component->Activate(true);
+		}
+	}
+}
+
+void AShooterProjectile::StopComponents()
+{
+	// a projectile whose life ended in flight never exploded, its looping audio and trail are still playing
+	for (UActorComponent* Component : GetComponents())
+	{
+		if (UAudioComponent* AudioComp = Cast<UAudioComponent>(Component))
+		{
+			AudioComp->Stop();
+		}
+		else if (UParticleSystemComponent* PSC = Cast<UParticleSystemComponent>(Component))
+		{
+			PSC->DeactivateImmediate();
+		}
+	}
 }
 
 void AShooterProjectile::InitVelocity(FVector& ShootDirection)
@@ -112,12 +217,18 @@ void AShooterProjectile::DisableAndDestroy()
 	MovementComp->StopMovementImmediately();
 
 	// give clients some time to show explosion
-	SetLifeSpan( 2.0f );
+	SetProjectileLife( 2.0f );
 }
 
 ///CODE_SNIPPET_START: AActor::GetActorLocation AActor::GetActorRotation
 void AShooterProjectile::OnRep_Exploded()
 {
+	// a pooled projectile fired again is reset by OnRep_PoolState
+	if (!bExploded)
+	{
+		return;
+	}
+
 	FVector ProjDirection = GetActorForwardVector();
 
 	const FVector StartTrace = GetActorLocation() - ProjDirection * 200;
@@ -135,6 +246,21 @@ void AShooterProjectile::OnRep_Exploded()
 }
 ///CODE_SNIPPET_END
 
+void AShooterProjectile::OnRep_PoolState()
+{
+	if (!PoolState.bActive)
+	{
+		StopComponents();
+		return;
+	}
+
+	// fired again: the client copy restarts, unless the new shot has already exploded
+	if (!bExploded)
+	{
+		ResetComponents();
+	}
+}
+
 void AShooterProjectile::PostNetReceiveVelocity(const FVector& NewVelocity)
 {
 	if (MovementComp)
@@ -148,4 +274,5 @@ void AShooterProjectile::GetLifetimeReplicatedProps( TArray< FLifetimeProperty >
 	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
 	
 	DOREPLIFETIME( AShooterProjectile, bExploded );
+	DOREPLIFETIME( AShooterProjectile, PoolState );
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Weapons/ShooterProjectilePool.h"
+#include "Weapons/ShooterProjectile.h"
+#include "Weapons/ShooterWeapon_Projectile.h"
+
+static int32 ShooterProjectilePool = 1;
+FAutoConsoleVariableRef CVarShooterProjectilePool(
+	TEXT("p.ShooterProjectilePool"),
+	ShooterProjectilePool,
+	TEXT("Reuse projectile actors instead of destroying and spawning them.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+static int32 ShooterProjectilePoolSize = 32;
+FAutoConsoleVariableRef CVarShooterProjectilePoolSize(
+	TEXT("p.ShooterProjectilePoolSize"),
+	ShooterProjectilePoolSize,
+	TEXT("Maximum idle projectile actors kept for reuse, per world."),
+	ECVF_Default);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile actors spawned"), STAT_ShooterProjectilesSpawned, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile spawns avoided"), STAT_ShooterProjectilesReused, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Idle pooled projectiles"), STAT_ShooterProjectilesIdle, STATGROUP_ShooterWeapon);
+
+void UShooterProjectilePool::Deinitialize()
+{
+	IdleProjectiles.Empty();
+	SET_DWORD_STAT(STAT_ShooterProjectilesIdle, 0);
+
+	Super::Deinitialize();
+}
+
+UShooterProjectilePool* UShooterProjectilePool::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterProjectilePool && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterProjectilePool>() : nullptr;
+}
+
+AShooterProjectile* UShooterProjectilePool::SpawnProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTM, AShooterWeapon_Projectile* Weapon, FVector ShootDir)
+{
+	if (!ProjectileClass || !Weapon)
+	{
+		return nullptr;
+	}
+
+	for (int32 i = IdleProjectiles.Num() - 1; i >= 0; i--)
+	{
+		AShooterProjectile* Projectile = IdleProjectiles[i];
+		if (!Projectile || Projectile->IsPendingKill())
+		{
+			IdleProjectiles.RemoveAtSwap(i);
+			continue;
+		}
+
+		if (Projectile->GetClass() == ProjectileClass)
+		{
+			IdleProjectiles.RemoveAtSwap(i);
+			SET_DWORD_STAT(STAT_ShooterProjectilesIdle, IdleProjectiles.Num());
+			INC_DWORD_STAT(STAT_ShooterProjectilesReused);
+
+			Projectile->SetInstigator(Weapon->GetInstigator());
+			Projectile->SetOwner(Weapon);
+			Projectile->Reactivate(SpawnTM, ShootDir);
+			return Projectile;
+		}
+	}
+
+	AShooterProjectile* Projectile = Cast<AShooterProjectile>(UGameplayStatics::BeginDeferredActorSpawnFromClass(Weapon, ProjectileClass, SpawnTM));
+	if (Projectile)
+	{
+		INC_DWORD_STAT(STAT_ShooterProjectilesSpawned);
+
+		Projectile->bPooled = true;
+		Projectile->SetInstigator(Weapon->GetInstigator());
+		Projectile->SetOwner(Weapon);
+		Projectile->InitVelocity(ShootDir);
+
+		UGameplayStatics::FinishSpawningActor(Projectile, SpawnTM);
+	}
+
+	return Projectile;
+}
+
+void UShooterProjectilePool::Release(AShooterProjectile* Projectile)
+{
+	if (!Projectile || Projectile->IsPendingKill())
+	{
+		return;
+	}
+
+	if (IdleProjectiles.Num() >= ShooterProjectilePoolSize)
+	{
+		Projectile->Destroy();
+		return;
+	}
+
+	Projectile->Deactivate();
+	IdleProjectiles.Add(Projectile);
+	SET_DWORD_STAT(STAT_ShooterProjectilesIdle, IdleProjectiles.Num());
+}
@@ -0,0 +1,222 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ShooterGame.h"
+#include "Weapons/ShooterProjectileSimulation.h"
+#include "Weapons/ShooterProjectile.h"
+#include "Weapons/ShooterWeapon_Projectile.h"
+#include "Effects/ShooterExplosionEffect.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Particles/ParticleSystemComponent.h"
+
+static int32 ShooterSimulatedProjectiles = 0;
+FAutoConsoleVariableRef CVarShooterSimulatedProjectiles(
+	TEXT("p.ShooterSimulatedProjectiles"),
+	ShooterSimulatedProjectiles,
+	TEXT("Simulate projectiles in a per world array instead of spawning replicated actors.\n")
+	TEXT("Only spawn and explode events are replicated. Must match on server and clients.\n")
+	TEXT("0: Disable, 1: Enable"),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Simulate projectiles"), STAT_ShooterSimulateProjectiles, STATGROUP_ShooterWeapon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Simulated projectiles"), STAT_ShooterSimulatedProjectiles, STATGROUP_ShooterWeapon);
+
+void UShooterProjectileSimulation::Deinitialize()
+{
+	for (int32 i = Projectiles.Num() - 1; i >= 0; i--)
+	{
+		RemoveProjectile(i);
+	}
+
+	Super::Deinitialize();
+}
+
+bool UShooterProjectileSimulation::IsTickable() const
+{
+	return Projectiles.Num() > 0;
+}
+
+TStatId UShooterProjectileSimulation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterProjectileSimulation, STATGROUP_Tickables);
+}
+
+UShooterProjectileSimulation* UShooterProjectileSimulation::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = (ShooterSimulatedProjectiles && WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return (World && World->IsGameWorld()) ? World->GetSubsystem<UShooterProjectileSimulation>() : nullptr;
+}
+
+void UShooterProjectileSimulation::FireProjectile(AShooterWeapon_Projectile* Weapon, const FProjectileWeaponData& WeaponConfig, const FVector& Origin, const FVector& ShootDir)
+{
+	const AShooterProjectile* Defaults = WeaponConfig.ProjectileClass ? WeaponConfig.ProjectileClass->GetDefaultObject<AShooterProjectile>() : nullptr;
+	if (!Weapon || !Defaults)
+	{
+		return;
+	}
+
+	const uint16 ProjectileId = NextId++;
+
+	FShooterSimulatedProjectile& Projectile = AddProjectile(Defaults, Origin, ShootDir, ProjectileId, true);
+	Projectile.TimeLeft = WeaponConfig.ProjectileLife;
+	Projectile.ExplosionDamage = WeaponConfig.ExplosionDamage;
+	Projectile.ExplosionRadius = WeaponConfig.ExplosionRadius;
+	Projectile.DamageType = WeaponConfig.DamageType;
+	Projectile.Instigator = Weapon->GetInstigator();
+	Projectile.Controller = Weapon->GetInstigatorController();
+	Projectile.Weapon = Weapon;
+
+	if (AShooterGameState* GameState = GetWorld()->GetGameState<AShooterGameState>())
+	{
+		GameState->MulticastSimulatedProjectileFired(WeaponConfig.ProjectileClass, Origin, ShootDir, ProjectileId, WeaponConfig.ProjectileLife);
+	}
+}
+
+void UShooterProjectileSimulation::SimulateProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FVector& Origin, const FVector& ShootDir, uint16 ProjectileId, float ProjectileLife)
+{
+	const AShooterProjectile* Defaults = ProjectileClass ? ProjectileClass->GetDefaultObject<AShooterProjectile>() : nullptr;
+	if (Defaults && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		// the server removes expired projectiles silently, the visual gets the same life
+		FShooterSimulatedProjectile& Projectile = AddProjectile(Defaults, Origin, ShootDir, ProjectileId, false);
+		Projectile.TimeLeft = ProjectileLife;
+	}
+}
+
+void UShooterProjectileSimulation::ExplodeProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, uint16 ProjectileId, const FVector& ImpactPoint, const FVector& ImpactNormal)
+{
+	for (int32 i = 0; i < Projectiles.Num(); i++)
+	{
+		if (!Projectiles[i].bAuthority && Projectiles[i].Id == ProjectileId)
+		{
+			RemoveProjectile(i);
+			break;
+		}
+	}
+
+	const AShooterProjectile* Defaults = ProjectileClass ? ProjectileClass->GetDefaultObject<AShooterProjectile>() : nullptr;
+	if (Defaults && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		FHitResult Impact;
+		Impact.ImpactPoint = ImpactPoint;
+		Impact.ImpactNormal = ImpactNormal;
+		SpawnExplosionEffect(Defaults, Impact);
+	}
+}
+
+FShooterSimulatedProjectile& UShooterProjectileSimulation::AddProjectile(const AShooterProjectile* Defaults, const FVector& Origin, const FVector& ShootDir, uint16 ProjectileId, bool bAuthority)
+{
+	FShooterSimulatedProjectile& Projectile = Projectiles.AddDefaulted_GetRef();
+	Projectile.Location = Origin;
+	Projectile.Velocity = ShootDir * Defaults->GetMovementComp()->InitialSpeed;
+	Projectile.TimeLeft = 0.0f;
+	Projectile.Id = ProjectileId;
+	Projectile.bAuthority = bAuthority;
+	Projectile.Defaults = Defaults;
+	Projectile.ExplosionDamage = 0;
+	Projectile.ExplosionRadius = 0.0f;
+
+	UParticleSystem* TrailFX = Defaults->GetParticleComp()->Template;
+	if (TrailFX && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		UShooterEffectPool* EffectPool = UShooterEffectPool::Get(this);
+		Projectile.TrailPSC = EffectPool ? EffectPool->SpawnEmitter(TrailFX, Origin, ShootDir.Rotation()) : UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), TrailFX, Origin, ShootDir.Rotation());
+	}
+
+	SET_DWORD_STAT(STAT_ShooterSimulatedProjectiles, Projectiles.Num());
+	return Projectile;
+}
+
+void UShooterProjectileSimulation::RemoveProjectile(int32 Index)
+{
+	if (UParticleSystemComponent* TrailPSC = Projectiles[Index].TrailPSC.Get())
+	{
+		TrailPSC->DeactivateSystem();
+	}
+
+	Projectiles.RemoveAtSwap(Index, 1, false);
+	SET_DWORD_STAT(STAT_ShooterSimulatedProjectiles, Projectiles.Num());
+}
+
+void UShooterProjectileSimulation::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterSimulateProjectiles);
+
+	UWorld* World = GetWorld();
+	const float GravityZ = World->GetGravityZ();
+
+	// backwards, so that removed projectiles can be swapped with already stepped ones
+	for (int32 i = Projectiles.Num() - 1; i >= 0; i--)
+	{
+		FShooterSimulatedProjectile& Projectile = Projectiles[i];
+
+		Projectile.TimeLeft -= DeltaTime;
+		if (Projectile.TimeLeft <= 0.0f)
+		{
+			RemoveProjectile(i);
+			continue;
+		}
+
+		const UProjectileMovementComponent* MovementDefaults = Projectile.Defaults->GetMovementComp();
+		const USphereComponent* CollisionDefaults = Projectile.Defaults->GetCollisionComp();
+
+		Projectile.Velocity.Z += GravityZ * MovementDefaults->ProjectileGravityScale * DeltaTime;
+		const FVector End = Projectile.Location + Projectile.Velocity * DeltaTime;
+
+		// same sweep as the projectile actor's collision component
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(SimulatedProjectile), CollisionDefaults->bTraceComplexOnMove, Projectile.Instigator.Get());
+		FHitResult Impact;
+		const bool bHit = World->SweepSingleByChannel(Impact, Projectile.Location, End, FQuat::Identity, COLLISION_PROJECTILE,
+			FCollisionShape::MakeSphere(CollisionDefaults->GetUnscaledSphereRadius()), Params, FCollisionResponseParams(CollisionDefaults->GetCollisionResponseToChannels()));
+
+		Projectile.Location = bHit ? Impact.Location : End;
+		if (UParticleSystemComponent* TrailPSC = Projectile.TrailPSC.Get())
+		{
+			TrailPSC->SetWorldLocationAndRotation(Projectile.Location, Projectile.Velocity.Rotation());
+		}
+
+		if (bHit)
+		{
+			// clients wait for the explode event, visuals just stop
+			if (Projectile.bAuthority)
+			{
+				Explode(Projectile, Impact);
+			}
+			RemoveProjectile(i);
+		}
+	}
+}
+
+void UShooterProjectileSimulation::Explode(const FShooterSimulatedProjectile& Projectile, const FHitResult& Impact)
+{
+	// effects and damage origin shouldn't be placed inside mesh at impact point
+	const FVector NudgedImpactLocation = Impact.ImpactPoint + Impact.ImpactNormal * 10.0f;
+
+	if (Projectile.ExplosionDamage > 0 && Projectile.ExplosionRadius > 0 && Projectile.DamageType)
+	{
+		// there is no projectile actor: the firing weapon causes the damage, or its owner once the weapon is gone
+		AActor* DamageCauser = Projectile.Weapon.IsValid() ? Projectile.Weapon.Get() : Projectile.Instigator.Get();
+		UGameplayStatics::ApplyRadialDamage(this, Projectile.ExplosionDamage, NudgedImpactLocation, Projectile.ExplosionRadius, Projectile.DamageType, TArray<AActor*>(), DamageCauser, Projectile.Controller.Get());
+	}
+
+	// the event plays the explosion everywhere, including on a listen server
+	if (AShooterGameState* GameState = GetWorld()->GetGameState<AShooterGameState>())
+	{
+		GameState->MulticastSimulatedProjectileExploded(Projectile.Defaults->GetClass(), Projectile.Id, Impact.ImpactPoint, Impact.ImpactNormal);
+	}
+}
+
+void UShooterProjectileSimulation::SpawnExplosionEffect(const AShooterProjectile* Defaults, const FHitResult& Impact)
+{
+	if (Defaults->ExplosionTemplate)
+	{
+		const FVector NudgedImpactLocation = Impact.ImpactPoint + Impact.ImpactNormal * 10.0f;
+
+		FTransform const SpawnTransform(Impact.ImpactNormal.Rotation(), NudgedImpactLocation);
+		AShooterExplosionEffect* const EffectActor = GetWorld()->SpawnActorDeferred<AShooterExplosionEffect>(Defaults->ExplosionTemplate, SpawnTransform);
+		if (EffectActor)
+		{
+			EffectActor->SurfaceHit = Impact;
+			UGameplayStatics::FinishSpawningActor(EffectActor, SpawnTransform);
+		}
+	}
+}
@@ -3,7 +3,175 @@
 #include "ShooterGame.h"
 #include "Weapons/ShooterWeapon_Instant.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Effects/ShooterImpactEffect.h"
+#include "Effects/ShooterEffectPool.h"
+#include "Weapons/ShooterLagCompensation.h"
+
+FAutoConsoleCommandWithWorldAndArgs ShooterMeasureHitReportCmd(TEXT("ShooterWeapon.MeasureHitReport"), TEXT("Compares the size of hit RPC payloads, FHitResult against FShooterHitReport, on random shots from local players. Usage: ShooterWeapon.MeasureHitReport [Shots=100]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+{
+	const int32 Shots = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+	FRandomStream RandomStream(Shots);
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PC = It->Get();
+		UNetConnection* Connection = PC ? PC->GetNetConnection() : nullptr;
+		if (!PC->IsLocalController() || !Connection || !Connection->PackageMap)
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(WeaponTrace), true, PC->GetPawn());
+		int64 HitResultBits = 0;
+		int64 HitReportBits = 0;
+		int32 Hits = 0;
+
+		for (int32 i = 0; i < Shots; i++)
+		{
+			const FVector ShootDir = RandomStream.VRandCone(ViewRotation.Vector(), FMath::DegreesToRadians(30.0f));
+			FHitResult Impact(ForceInit);
+			TraceParams.bReturnPhysicalMaterial = true;
+			if (!World->LineTraceSingleByChannel(Impact, ViewLocation, ViewLocation + ShootDir * 10000.0f, COLLISION_WEAPON, TraceParams))
+			{
+				continue;
+			}
+			Hits++;
+
+			// previous payload: the whole FHitResult, and the shot direction
+			bool bSuccess = true;
+			FNetBitWriter HitResultWriter(Connection->PackageMap, 0);
+			Impact.NetSerialize(HitResultWriter, Connection->PackageMap, bSuccess);
+			FVector_NetQuantizeNormal QuantizedDir(ShootDir);
+			QuantizedDir.NetSerialize(HitResultWriter, Connection->PackageMap, bSuccess);
+			HitResultBits += HitResultWriter.GetNumBits();
+
+			FNetBitWriter HitReportWriter(Connection->PackageMap, 0);
+			FShooterHitReport HitReport = FShooterHitReport::FromHitResult(Impact);
+			HitReport.AimDir = ViewRotation.Vector();
+			HitReport.NetSerialize(HitReportWriter, Connection->PackageMap, bSuccess);
+			HitReportBits += HitReportWriter.GetNumBits();
+		}
+
+		// RandomSeed, ReticleSpread and ShotTime are sent by both
+		const int64 SharedBits = 3 * 32;
+		UE_LOG(LogShooterWeapon, Display, TEXT("%s: %d hits out of %d shots. FHitResult + ShootDir: %.1f bits/hit, FShooterHitReport: %.1f bits/hit (%.1f and %.1f bits per RPC payload, %.2fx smaller)"),
+			*GetNameSafe(PC), Hits, Shots, Hits ? (double)HitResultBits / Hits : 0.0, Hits ? (double)HitReportBits / Hits : 0.0,
+			Hits ? (double)HitResultBits / Hits + SharedBits : 0.0, Hits ? (double)HitReportBits / Hits + SharedBits : 0.0,
+			HitReportBits ? (double)(HitResultBits + SharedBits * Hits) / (HitReportBits + SharedBits * Hits) : 0.0);
+	}
+}));
+
+//////////////////////////////////////////////////////////////////////////
+// FShooterHitReport
+
+FShooterHitReport FShooterHitReport::FromHitResult(const FHitResult& Impact, uint8 InPelletIndex)
+{
+	FShooterHitReport Report;
+	Report.Actor = Impact.GetActor();
+	Report.Location = Impact.Location;
+	Report.PelletIndex = InPelletIndex;
+	Report.PhysMaterial = Impact.PhysMaterial;
+
+	const USkinnedMeshComponent* SkinnedMesh = Cast<USkinnedMeshComponent>(Impact.GetComponent());
+	if (SkinnedMesh && Impact.BoneName != NAME_None)
+	{
+		Report.BoneIndex = (int16)SkinnedMesh->GetBoneIndex(Impact.BoneName);
+	}
+
+	return Report;
+}
+
+FHitResult FShooterHitReport::ToHitResult(const FVector& ShootDir) const
+{
+	// the impact normal isn't sent, it's only used by FX
+	FHitResult Impact(Actor, nullptr, Location, -ShootDir);
+	Impact.bBlockingHit = true;
+	Impact.TraceStart = Location - ShootDir;
+	Impact.TraceEnd = Location + ShootDir;
+	Impact.PhysMaterial = PhysMaterial;
+
+	// bones are only hit on character meshes
+	const ACharacter* Character = Cast<ACharacter>(Actor);
+	USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	if (Mesh && BoneIndex != INDEX_NONE && BoneIndex < Mesh->GetNumBones())
+	{
+		Impact.Component = Mesh;
+		Impact.BoneName = Mesh->GetBoneName(BoneIndex);
+	}
+	else if (Actor)
+	{
+		Impact.Component = Cast<UPrimitiveComponent>(Actor->GetRootComponent());
+	}
+
+	return Impact;
+}
+
+bool FShooterHitReport::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	UObject* ActorObject = Actor;
+	Ar << ActorObject;
+	Actor = Cast<AActor>(ActorObject);
+
+	bOutSuccess = true;
+	Location.NetSerialize(Ar, Map, bOutSuccess);
+
+	uint8 bHasBone = BoneIndex != INDEX_NONE;
+	Ar.SerializeBits(&bHasBone, 1);
+	if (bHasBone)
+	{
+		Ar << BoneIndex;
+	}
+	else
+	{
+		BoneIndex = INDEX_NONE;
+	}
+
+	uint8 bHasPellet = PelletIndex != 0;
+	Ar.SerializeBits(&bHasPellet, 1);
+	if (bHasPellet)
+	{
+		Ar << PelletIndex;
+	}
+	else
+	{
+		PelletIndex = 0;
+	}
+
+	uint8 bHasAim = !AimDir.IsZero();
+	Ar.SerializeBits(&bHasAim, 1);
+	if (bHasAim)
+	{
+		AimDir.NetSerialize(Ar, Map, bOutSuccess);
+	}
+	else
+	{
+		AimDir = FVector::ZeroVector;
+	}
+
+	uint8 bHasPhysMaterial = PhysMaterial.IsValid();
+	Ar.SerializeBits(&bHasPhysMaterial, 1);
+	if (bHasPhysMaterial)
+	{
+		UObject* PhysMaterialObject = PhysMaterial.Get();
+		Ar << PhysMaterialObject;
+		PhysMaterial = Cast<UPhysicalMaterial>(PhysMaterialObject);
+	}
+	else
+	{
+		PhysMaterial = nullptr;
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AShooterWeapon_Instant
 
 AShooterWeapon_Instant::AShooterWeapon_Instant(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -16,27 +184,127 @@ AShooterWeapon_Instant::AShooterWeapon_Instant(const FObjectInitializer& ObjectI
 void AShooterWeapon_Instant::FireWeapon()
 {
 	const int32 RandomSeed = FMath::Rand();
-	FRandomStream WeaponRandomStream(RandomSeed);
 	const float CurrentSpread = GetCurrentSpread();
-	const float ConeHalfAngle = FMath::DegreesToRadians(CurrentSpread * 0.5f);
 
 	const FVector AimDir = GetAdjustedAim();
 	const FVector StartTrace = GetCameraDamageStartLocation(AimDir);
-	const FVector ShootDir = WeaponRandomStream.VRandCone(AimDir, ConeHalfAngle, ConeHalfAngle);
+
+	if (InstantConfig.PelletCount > 1)
+	{
+		FirePellets(AimDir, StartTrace, RandomSeed, CurrentSpread);
+		CurrentFiringSpread = FMath::Min(InstantConfig.FiringSpreadMax, CurrentFiringSpread + InstantConfig.FiringSpreadIncrement);
+		return;
+	}
+
+	// same cone as the server and remote clients, which regenerate the shot from its seed
+	TArray<FVector, TInlineAllocator<32>> ShootDirs;
+	GetPelletDirections(AimDir, RandomSeed, CurrentSpread, ShootDirs);
+	const FVector& ShootDir = ShootDirs[0];
 	const FVector EndTrace = StartTrace + ShootDir * InstantConfig.WeaponRange;
 
 	const FHitResult Impact = WeaponTrace(StartTrace, EndTrace);
-	ProcessInstantHit(Impact, StartTrace, ShootDir, RandomSeed, CurrentSpread);
+	ProcessInstantHit(Impact, StartTrace, AimDir, ShootDir, RandomSeed, CurrentSpread);
 
 	CurrentFiringSpread = FMath::Min(InstantConfig.FiringSpreadMax, CurrentFiringSpread + InstantConfig.FiringSpreadIncrement);
 }
 
-bool AShooterWeapon_Instant::ServerNotifyHit_Validate(const FHitResult& Impact, FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::FirePellets(const FVector& AimDir, const FVector& StartTrace, int32 RandomSeed, float ReticleSpread)
+{
+	TArray<FVector, TInlineAllocator<32>> PelletDirs;
+	GetPelletDirections(AimDir, RandomSeed, ReticleSpread, PelletDirs);
+
+	const bool bNotifyServer = MyPawn && MyPawn->IsLocallyControlled() && GetNetMode() == NM_Client;
+	TArray<FShooterHitReport> PelletHits;
+
+	// all pellets are traced in a row, then hits are reported at once
+	for (int32 PelletIndex = 0; PelletIndex < PelletDirs.Num(); PelletIndex++)
+	{
+		const FVector& ShootDir = PelletDirs[PelletIndex];
+		const FHitResult Impact = WeaponTrace(StartTrace, StartTrace + ShootDir * InstantConfig.WeaponRange);
+
+		// same rules as ProcessInstantHit: hits on server controlled actors and world geometry are reported
+		if (bNotifyServer && ((Impact.GetActor() && Impact.GetActor()->GetRemoteRole() == ROLE_Authority) || (!Impact.GetActor() && Impact.bBlockingHit)))
+		{
+			PelletHits.Add(FShooterHitReport::FromHitResult(Impact, (uint8)PelletIndex));
+		}
+
+		ProcessInstantHit_Confirmed(Impact, StartTrace, AimDir, ShootDir, RandomSeed, ReticleSpread);
+	}
+
+	// the server also needs misses, to replicate the shot FX
+	if (bNotifyServer)
+	{
+		ServerNotifyPelletHits(AimDir, RandomSeed, ReticleSpread, GetShotTime(), PelletHits);
+	}
+}
+
+bool AShooterWeapon_Instant::ServerNotifyPelletHits_Validate(FVector_NetQuantizeNormal AimDir, int32 RandomSeed, float ReticleSpread, float ShotTime, const TArray<FShooterHitReport>& PelletHits)
+{
+	return PelletHits.Num() <= InstantConfig.PelletCount;
+}
+
+void AShooterWeapon_Instant::ServerNotifyPelletHits_Implementation(FVector_NetQuantizeNormal AimDir, int32 RandomSeed, float ReticleSpread, float ShotTime, const TArray<FShooterHitReport>& PelletHits)
+{
+	const FVector Origin = GetMuzzleLocation();
+
+	TArray<FVector, TInlineAllocator<32>> PelletDirs;
+	GetPelletDirections(AimDir, RandomSeed, ReticleSpread, PelletDirs);
+
+	// play FX on remote clients, they simulate every pellet from the seed
+	HitNotify.Origin = Origin;
+	HitNotify.AimDir = AimDir;
+	HitNotify.RandomSeed = RandomSeed;
+	HitNotify.ReticleSpread = ReticleSpread;
+
+	uint32 ReportedPellets = 0;
+	for (const FShooterHitReport& PelletHit : PelletHits)
+	{
+		if (PelletHit.PelletIndex >= PelletDirs.Num() || (ReportedPellets & (1u << PelletHit.PelletIndex)))
+		{
+			UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected invalid client side pellet %d"), *GetNameSafe(this), PelletHit.PelletIndex);
+			continue;
+		}
+		ReportedPellets |= 1u << PelletHit.PelletIndex;
+
+		const FVector& ShootDir = PelletDirs[PelletHit.PelletIndex];
+		ValidateClientHit(PelletHit.ToHitResult(ShootDir), AimDir, ShootDir, RandomSeed, ReticleSpread, ShotTime);
+	}
+
+	// play missed pellets FX locally
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		for (int32 PelletIndex = 0; PelletIndex < PelletDirs.Num(); PelletIndex++)
+		{
+			if (!(ReportedPellets & (1u << PelletIndex)))
+			{
+				SpawnTrailEffect(Origin + PelletDirs[PelletIndex] * InstantConfig.WeaponRange);
+			}
+		}
+	}
+}
+
+bool AShooterWeapon_Instant::ServerNotifyHit_Validate(const FShooterHitReport& HitReport, int32 RandomSeed, float ReticleSpread, float ShotTime)
 {
 	return true;
 }
 
-void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FHitResult& Impact, FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FShooterHitReport& HitReport, int32 RandomSeed, float ReticleSpread, float ShotTime)
+{
+	if (HitReport.AimDir.IsZero())
+	{
+		UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected client side hit of %s (no aim direction)"), *GetNameSafe(this), *GetNameSafe(HitReport.Actor));
+		return;
+	}
+
+	// the shot direction is regenerated like the client did, from its aim and the shot seed
+	TArray<FVector, TInlineAllocator<32>> ShootDirs;
+	GetPelletDirections(HitReport.AimDir, RandomSeed, ReticleSpread, ShootDirs);
+	const FVector& ShootDir = ShootDirs[0];
+
+	ValidateClientHit(HitReport.ToHitResult(ShootDir), HitReport.AimDir, ShootDir, RandomSeed, ReticleSpread, ShotTime);
+}
+
+void AShooterWeapon_Instant::ValidateClientHit(const FHitResult& Impact, const FVector& AimDir, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread, float ShotTime)
 {
 	const float WeaponAngleDot = FMath::Abs(FMath::Sin(ReticleSpread * PI / 180.f));
 
@@ -56,43 +324,30 @@ void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FHitResult& Im
 				{
 					if (Impact.bBlockingHit)
 					{
-						ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
+						ProcessInstantHit_Confirmed(Impact, Origin, AimDir, ShootDir, RandomSeed, ReticleSpread);
 					}
 				}
 				// assume it told the truth about static things because the don't move and the hit 
 				// usually doesn't have significant gameplay implications
 				else if (Impact.GetActor()->IsRootComponentStatic() || Impact.GetActor()->IsRootComponentStationary())
 				{
-					ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
+					ProcessInstantHit_Confirmed(Impact, Origin, AimDir, ShootDir, RandomSeed, ReticleSpread);
 				}
-				else
+				else if (UShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensation>())
 				{
-					// Get the component bounding box
-					const FBox HitBox = Impact.GetActor()->GetComponentsBoundingBox();
-
-					// calculate the box extent, and increase by a leeway
-					FVector BoxExtent = 0.5 * (HitBox.Max - HitBox.Min);
-					BoxExtent *= InstantConfig.ClientSideHitLeeway;
-
-					// avoid precision errors with really thin objects
-					BoxExtent.X = FMath::Max(20.0f, BoxExtent.X);
-					BoxExtent.Y = FMath::Max(20.0f, BoxExtent.Y);
-					BoxExtent.Z = FMath::Max(20.0f, BoxExtent.Z);
-
-					// Get the box center
-					const FVector BoxCenter = (HitBox.Min + HitBox.Max) * 0.5;
-
-					// if we are within client tolerance
-					if (FMath::Abs(Impact.Location.Z - BoxCenter.Z) < BoxExtent.Z &&
-						FMath::Abs(Impact.Location.X - BoxCenter.X) < BoxExtent.X &&
-						FMath::Abs(Impact.Location.Y - BoxCenter.Y) < BoxExtent.Y)
-					{
-						ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
-					}
-					else
-					{
-						UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected client side hit of %s (outside bounding box tolerance)"), *GetNameSafe(this), *GetNameSafe(Impact.GetActor()));
-					}
+					// check the hit against the bounding box where the target was when the client fired,
+					// together with all the hits received this frame, see OnHitValidated
+					FShooterPendingHit Hit;
+					Hit.Weapon = this;
+					Hit.Impact = Impact;
+					Hit.Origin = Origin;
+					Hit.AimDir = AimDir;
+					Hit.ShootDir = ShootDir;
+					Hit.RandomSeed = RandomSeed;
+					Hit.ReticleSpread = ReticleSpread;
+					Hit.ShotTime = ShotTime;
+					Hit.Leeway = InstantConfig.ClientSideHitLeeway;
+					LagCompensation->QueueHit(MoveTemp(Hit));
 				}
 			}
 		}
@@ -107,58 +362,80 @@ void AShooterWeapon_Instant::ServerNotifyHit_Implementation(const FHitResult& Im
 	}
 }
 
-bool AShooterWeapon_Instant::ServerNotifyMiss_Validate(FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::OnHitValidated(const FShooterPendingHit& Hit, bool bConfirmed)
+{
+	if (bConfirmed)
+	{
+		ProcessInstantHit_Confirmed(Hit.Impact, Hit.Origin, Hit.AimDir, Hit.ShootDir, Hit.RandomSeed, Hit.ReticleSpread);
+	}
+	else
+	{
+		UE_LOG(LogShooterWeapon, Log, TEXT("%s Rejected client side hit of %s (outside bounding box tolerance)"), *GetNameSafe(this), *GetNameSafe(Hit.Impact.GetActor()));
+	}
+}
+
+bool AShooterWeapon_Instant::ServerNotifyMiss_Validate(FVector_NetQuantizeNormal AimDir, int32 RandomSeed, float ReticleSpread)
 {
 	return true;
 }
 
-void AShooterWeapon_Instant::ServerNotifyMiss_Implementation(FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ServerNotifyMiss_Implementation(FVector_NetQuantizeNormal AimDir, int32 RandomSeed, float ReticleSpread)
 {
 	const FVector Origin = GetMuzzleLocation();
 
 	// play FX on remote clients
 	HitNotify.Origin = Origin;
+	HitNotify.AimDir = AimDir;
 	HitNotify.RandomSeed = RandomSeed;
 	HitNotify.ReticleSpread = ReticleSpread;
 
 	// play FX locally
 	if (GetNetMode() != NM_DedicatedServer)
 	{
+		TArray<FVector, TInlineAllocator<32>> ShootDirs;
+		GetPelletDirections(AimDir, RandomSeed, ReticleSpread, ShootDirs);
+		const FVector& ShootDir = ShootDirs[0];
 		const FVector EndTrace = Origin + ShootDir * InstantConfig.WeaponRange;
 		SpawnTrailEffect(EndTrace);
 	}
 }
 
-void AShooterWeapon_Instant::ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& AimDir, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread)
 {
 	if (MyPawn && MyPawn->IsLocallyControlled() && GetNetMode() == NM_Client)
 	{
 		// if we're a client and we've hit something that is being controlled by the server
+		const float ShotTime = GetShotTime();
+
+		// the server regenerates the shot direction from the client aim
+		FShooterHitReport HitReport = FShooterHitReport::FromHitResult(Impact);
+		HitReport.AimDir = AimDir;
+
 		if (Impact.GetActor() && Impact.GetActor()->GetRemoteRole() == ROLE_Authority)
 		{
 			// notify the server of the hit
-			ServerNotifyHit(Impact, ShootDir, RandomSeed, ReticleSpread);
+			ServerNotifyHit(HitReport, RandomSeed, ReticleSpread, ShotTime);
 		}
 		else if (Impact.GetActor() == NULL)
 		{
 			if (Impact.bBlockingHit)
 			{
 				// notify the server of the hit
-				ServerNotifyHit(Impact, ShootDir, RandomSeed, ReticleSpread);
+				ServerNotifyHit(HitReport, RandomSeed, ReticleSpread, ShotTime);
 			}
 			else
 			{
 				// notify server of the miss
-				ServerNotifyMiss(ShootDir, RandomSeed, ReticleSpread);
+				ServerNotifyMiss(AimDir, RandomSeed, ReticleSpread);
 			}
 		}
 	}
 
 	// process a confirmed hit
-	ProcessInstantHit_Confirmed(Impact, Origin, ShootDir, RandomSeed, ReticleSpread);
+	ProcessInstantHit_Confirmed(Impact, Origin, AimDir, ShootDir, RandomSeed, ReticleSpread);
 }
 
-void AShooterWeapon_Instant::ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread)
+void AShooterWeapon_Instant::ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& AimDir, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread)
 {
 	// handle damage
 	if (ShouldDealDamage(Impact.GetActor()))
@@ -170,6 +447,7 @@ void AShooterWeapon_Instant::ProcessInstantHit_Confirmed(const FHitResult& Impac
 	if (GetLocalRole() == ROLE_Authority)
 	{
 		HitNotify.Origin = Origin;
+		HitNotify.AimDir = AimDir;
 		HitNotify.RandomSeed = RandomSeed;
 		HitNotify.ReticleSpread = ReticleSpread;
 	}
@@ -238,30 +516,45 @@ float AShooterWeapon_Instant::GetCurrentSpread() const
 //////////////////////////////////////////////////////////////////////////
 // Replication & effects
 
-void AShooterWeapon_Instant::OnRep_HitNotify()
+void AShooterWeapon_Instant::GetPelletDirections(const FVector& AimDir, int32 RandomSeed, float ReticleSpread, TArray<FVector, TInlineAllocator<32>>& OutDirections) const
 {
-	SimulateInstantHit(HitNotify.Origin, HitNotify.RandomSeed, HitNotify.ReticleSpread);
+	FRandomStream WeaponRandomStream(RandomSeed);
+	const float ConeHalfAngle = FMath::DegreesToRadians((ReticleSpread + InstantConfig.PelletSpread) * 0.5f);
+
+	// pellets are drawn in order from the same stream, on the shooter, the server and remote clients
+	const int32 PelletCount = FMath::Clamp(InstantConfig.PelletCount, 1, 32);
+	for (int32 PelletIndex = 0; PelletIndex < PelletCount; PelletIndex++)
+	{
+		OutDirections.Add(WeaponRandomStream.VRandCone(AimDir, ConeHalfAngle, ConeHalfAngle));
+	}
 }
 
-void AShooterWeapon_Instant::SimulateInstantHit(const FVector& ShotOrigin, int32 RandomSeed, float ReticleSpread)
+float AShooterWeapon_Instant::GetShotTime() const
 {
-	FRandomStream WeaponRandomStream(RandomSeed);
-	const float ConeHalfAngle = FMath::DegreesToRadians(ReticleSpread * 0.5f);
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
 
-	const FVector StartTrace = ShotOrigin;
-	const FVector AimDir = GetAdjustedAim();
-	const FVector ShootDir = WeaponRandomStream.VRandCone(AimDir, ConeHalfAngle, ConeHalfAngle);
-	const FVector EndTrace = StartTrace + ShootDir * InstantConfig.WeaponRange;
+void AShooterWeapon_Instant::OnRep_HitNotify()
+{
+	SimulateInstantHit(HitNotify.Origin, HitNotify.AimDir, HitNotify.RandomSeed, HitNotify.ReticleSpread);
+}
 
-	FHitResult Impact = WeaponTrace(StartTrace, EndTrace);
-	if (Impact.bBlockingHit)
-	{
-		SpawnImpactEffects(Impact);
-		SpawnTrailEffect(Impact.ImpactPoint);
-	}
-	else
+void AShooterWeapon_Instant::SimulateInstantHit(const FVector& ShotOrigin, const FVector& AimDir, int32 RandomSeed, float ReticleSpread)
+{
+	// single shots and pellets share the cone of GetPelletDirections, and the shooter's aim, like the shooter and the server
+	TArray<FVector, TInlineAllocator<32>> PelletDirs;
+	GetPelletDirections(AimDir.IsZero() ? GetAdjustedAim() : AimDir, RandomSeed, ReticleSpread, PelletDirs);
+
+	for (const FVector& ShootDir : PelletDirs)
 	{
-		SpawnTrailEffect(EndTrace);
+		const FVector EndTrace = ShotOrigin + ShootDir * InstantConfig.WeaponRange;
+		const FHitResult Impact = WeaponTrace(ShotOrigin, EndTrace);
+		if (Impact.bBlockingHit)
+		{
+			SpawnImpactEffects(Impact);
+		}
+		SpawnTrailEffect(Impact.bBlockingHit ? Impact.ImpactPoint : EndTrace);
 	}
 }
 
@@ -281,6 +574,12 @@ void AShooterWeapon_Instant::SpawnImpactEffects(const FHitResult& Impact)
 		}
 
 		FTransform const SpawnTransform(Impact.ImpactNormal.Rotation(), Impact.ImpactPoint);
+		if (UShooterEffectPool* EffectPool = UShooterEffectPool::Get(this))
+		{
+			EffectPool->SpawnImpactEffect(ImpactTemplate, UseImpact, SpawnTransform);
+			return;
+		}
+
 		AShooterImpactEffect* EffectActor = GetWorld()->SpawnActorDeferred<AShooterImpactEffect>(ImpactTemplate, SpawnTransform);
 		if (EffectActor)
 		{
@@ -296,7 +595,8 @@ void AShooterWeapon_Instant::SpawnTrailEffect(const FVector& EndPoint)
 	{
 		const FVector Origin = GetMuzzleLocation();
 
-		UParticleSystemComponent* TrailPSC = UGameplayStatics::SpawnEmitterAtLocation(this, TrailFX, Origin);
+		UShooterEffectPool* EffectPool = UShooterEffectPool::Get(this);
+		UParticleSystemComponent* TrailPSC = EffectPool ? EffectPool->SpawnEmitter(TrailFX, Origin, FRotator::ZeroRotator) : UGameplayStatics::SpawnEmitterAtLocation(this, TrailFX, Origin);
 		if (TrailPSC)
 		{
 			TrailPSC->SetVectorParameter(TrailTargetParam, EndPoint);
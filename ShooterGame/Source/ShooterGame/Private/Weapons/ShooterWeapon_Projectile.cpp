@@ -3,6 +3,8 @@
 #include "ShooterGame.h"
 #include "Weapons/ShooterWeapon_Projectile.h"
 #include "Weapons/ShooterProjectile.h"
+#include "Weapons/ShooterProjectilePool.h"
+#include "Weapons/ShooterProjectileSimulation.h"
 
 AShooterWeapon_Projectile::AShooterWeapon_Projectile(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -71,7 +73,19 @@ bool AShooterWeapon_Projectile::ServerFireProjectile_Validate(FVector Origin, FV
 
 void AShooterWeapon_Projectile::ServerFireProjectile_Implementation(FVector Origin, FVector_NetQuantizeNormal ShootDir)
 {
+	if (UShooterProjectileSimulation* Simulation = UShooterProjectileSimulation::Get(this))
+	{
+		Simulation->FireProjectile(this, ProjectileConfig, Origin, ShootDir);
+		return;
+	}
+
 	FTransform SpawnTM(ShootDir.Rotation(), Origin);
+	if (UShooterProjectilePool* ProjectilePool = UShooterProjectilePool::Get(this))
+	{
+		ProjectilePool->SpawnProjectile(ProjectileConfig.ProjectileClass, SpawnTM, this, ShootDir);
+		return;
+	}
+
 	AShooterProjectile* Projectile = Cast<AShooterProjectile>(UGameplayStatics::BeginDeferredActorSpawnFromClass(this, ProjectileConfig.ProjectileClass, SpawnTM));
 	if (Projectile)
 	{
@@ -11,4 +11,10 @@ class UBTTask_FindPickup : public UBTTask_BlackboardBase
 	GENERATED_UCLASS_BODY()
 		
 	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+protected:
+
+	/** rank the closest pickups by navigation path cost instead of straight line distance */
+	UPROPERTY(EditAnywhere, Category=Pickup)
+	uint32 bRankByPathCost:1;
 };
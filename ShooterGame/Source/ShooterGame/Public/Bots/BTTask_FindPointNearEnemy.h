@@ -5,11 +5,25 @@
 #include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
 #include "BTTask_FindPointNearEnemy.generated.h"
 
+struct FBTFindPointNearEnemyMemory
+{
+	/** pending navigation query, 0 if none */
+	uint32 RequestId;
+};
+
 // Bot AI task that tries to find a location near the current enemy
+// The navigation query is queued in the world's UShooterNavQueryBatcher, and the task waits for its result
 UCLASS()
 class UBTTask_FindPointNearEnemy : public UBTTask_BlackboardBase
 {
 	GENERATED_UCLASS_BODY()
 
 	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+
+protected:
+
+	/** called by the batcher when the navigation query of OwnerComp is done */
+	void OnPointFound(TWeakObjectPtr<UBehaviorTreeComponent> OwnerComp, uint32 RequestId, bool bFound, const FVector& Point);
 };
@@ -52,6 +52,9 @@ public:
 		
 	bool HasWeaponLOSToEnemy(AActor* InEnemyActor, const bool bAnyEnemy) const;
 
+	/** Number of weapon LOS traces done by all bots, for benchmarks */
+	static uint64 GetWeaponLOSTraceCount() { return WeaponLOSTraceCount; }
+
 	// Begin AAIController interface
 	/** Update direction AI is looking based on FocalPoint */
 	virtual void UpdateControlRotation(float DeltaTime, bool bUpdatePawn = true) override;
@@ -67,6 +70,9 @@ protected:
 	/** Handle for efficient management of Respawn timer */
 	FTimerHandle TimerHandle_Respawn;
 
+	/** Weapon LOS traces counter */
+	static uint64 WeaponLOSTraceCount;
+
 public:
 	/** Returns BlackboardComp subobject **/
 	FORCEINLINE UBlackboardComponent* GetBlackboardComp() const { return BlackboardComp; }
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "ShooterAILODManager.generated.h"
+
+class UShooterBehaviorTreeComponent;
+
+namespace EShooterAILOD
+{
+	enum Type
+	{
+		/** close to a human player, updated every frame */
+		Near,
+		/** updated every p.ShooterAILODMidInterval */
+		Mid,
+		/** far from every human player, updated every p.ShooterAILODFarInterval */
+		Far,
+		MAX,
+	};
+}
+
+/**
+ * Per world level of detail of bots, by distance to human players.
+ *
+ * Bots are bucketed by the distance between their pawn and the closest human player view point, a few of them
+ * per frame (p.ShooterAILODBotsPerFrame), round robin. Far bots tick their behavior tree, and so run their target scans,
+ * at a lower rate, and at most p.ShooterAILODThrottledTicks of those throttled updates run per frame: the others wait,
+ * which spreads them across frames. Each frame, the budget of the next frame goes to the due bots that waited the
+ * longest, and a bot that waited several intervals updates anyway. Behavior tree time per frame is reported in stat ShooterAI.
+ */
+UCLASS()
+class UShooterAILODManager : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** manager of the world, null if AI LOD is disabled (p.ShooterAILOD 0) */
+	static UShooterAILODManager* Get(const UObject* WorldContextObject);
+
+	/** update interval of a LOD, 0 for every frame */
+	static float GetUpdateInterval(EShooterAILOD::Type LOD);
+
+	void RegisterBot(UShooterBehaviorTreeComponent* BehaviorComp);
+	void UnregisterBot(UShooterBehaviorTreeComponent* BehaviorComp);
+
+	/** should a bot update its behavior tree this frame, PendingDeltaTime seconds after its last update? */
+	bool ShouldTick(const UShooterBehaviorTreeComponent* BehaviorComp, float PendingDeltaTime);
+
+	/** adds behavior tree time to the current frame */
+	void AddTickCycles(uint64 Cycles) { TickCycles += Cycles; }
+
+	/** number of bots in a LOD */
+	int32 GetNumBots(EShooterAILOD::Type LOD) const { return NumBots[LOD]; }
+
+private:
+
+	/** behavior trees of all bots */
+	TArray<TWeakObjectPtr<UShooterBehaviorTreeComponent>> Bots;
+
+	/** next bot to bucket */
+	int32 NextBucketIndex;
+
+	/** bots per LOD */
+	int32 NumBots[EShooterAILOD::MAX];
+
+	/** due throttled bots that didn't update this frame, with the time since their last update */
+	TArray<TPair<FObjectKey, float>> WaitingBots;
+
+	/** throttled bots allowed to update this frame, the ones that waited the longest */
+	TSet<FObjectKey> GrantedBots;
+
+	/** behavior tree cycles since last manager tick */
+	uint64 TickCycles;
+
+	/** LOD of a bot from the distance to the closest human view point */
+	static EShooterAILOD::Type ComputeLOD(const APawn* Pawn, const TArray<FVector, TInlineAllocator<8>>& ViewLocations);
+};
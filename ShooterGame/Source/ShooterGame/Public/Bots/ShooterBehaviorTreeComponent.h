@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "Bots/ShooterAILODManager.h"
+#include "ShooterBehaviorTreeComponent.generated.h"
+
+/**
+ * Behavior tree component of bots, ticked at the rate chosen by UShooterAILODManager.
+ * Skipped frames are accumulated, so the tree sees the real elapsed time when it runs.
+ */
+UCLASS()
+class UShooterBehaviorTreeComponent : public UBehaviorTreeComponent
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+	/** current LOD, set by the manager */
+	EShooterAILOD::Type GetLOD() const { return LOD; }
+	void SetLOD(EShooterAILOD::Type NewLOD);
+
+	/** time skipped since last tree update */
+	float GetSkippedTime() const { return SkippedTime; }
+
+private:
+
+	EShooterAILOD::Type LOD;
+
+	float SkippedTime;
+};
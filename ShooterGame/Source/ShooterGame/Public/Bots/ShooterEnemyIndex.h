@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterEnemyIndex.generated.h"
+
+class AShooterCharacter;
+
+/**
+ * Per world spatial hash of living characters, shared by all bots for target acquisition.
+ *
+ * Characters are hashed on a 2D grid of p.ShooterEnemyIndexCellSize cells, rebuilt at most once per frame,
+ * on the first query. Queries walk grid rings outwards from the querier, so candidates come nearest first
+ * and a caller doing expensive checks (line of sight traces) can stop at the first one that passes.
+ * Who is an enemy is still decided by AShooterCharacter::IsEnemyFor, i.e. by the game mode team rules.
+ */
+UCLASS()
+class UShooterEnemyIndex : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** index of the world, null if it's disabled (p.ShooterEnemyIndex 0) */
+	static UShooterEnemyIndex* Get(const UObject* WorldContextObject);
+
+	/** calls Visitor for living enemies of Querier, nearest to Location first, until it returns false */
+	void ForEachEnemyByDistance(AController* Querier, const FVector& Location, TFunctionRef<bool(AShooterCharacter*)> Visitor);
+
+	/** up to MaxCount living enemies of Querier, nearest to Location first */
+	void GetNearestEnemies(AController* Querier, const FVector& Location, int32 MaxCount, TArray<AShooterCharacter*>& OutEnemies);
+
+	/** number of characters indexed this frame */
+	int32 GetNumIndexed() const { return Entries.Num(); }
+
+private:
+
+	struct FIndexedCharacter
+	{
+		AShooterCharacter* Pawn;
+		FVector Location;
+	};
+
+	/** living characters, valid for BuiltFrame only */
+	TArray<FIndexedCharacter> Entries;
+
+	/** indices in Entries, by grid cell. Emptied, not removed, on rebuild */
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	/** grid bounds of the indexed characters */
+	FIntPoint MinCell;
+	FIntPoint MaxCell;
+
+	/** frame of the last rebuild */
+	uint64 BuiltFrame;
+
+	/** cell size of the last rebuild */
+	float CellSize;
+
+	/** rebuilds the index, if it hasn't been done this frame */
+	void Update();
+
+	/** cell coordinates of a location */
+	FIntPoint GetCell(const FVector& Location) const;
+};
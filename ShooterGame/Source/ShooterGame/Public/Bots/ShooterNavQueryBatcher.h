@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AI/Navigation/NavQueryFilter.h"
+#include "ShooterNavQueryBatcher.generated.h"
+
+class ANavigationData;
+
+/** result of a reachable point query: request id, success and point (the search origin on failure) */
+typedef TFunction<void(uint32, bool, const FVector&)> FShooterNavPointCallback;
+
+/**
+ * Per world batcher of bot navigation point queries.
+ *
+ * Behavior tree tasks submit "reachable point near enemy" requests and wait for the result instead of querying the
+ * navmesh synchronously. Each frame, the p.ShooterNavQueryBudget oldest requests are run and the others wait for
+ * the next frames. Queries use the nav data and default filter of the requesting controller.
+ *
+ * Results are cached per enemy for p.ShooterNavQueryCacheTime seconds, so bots repositioning around the same enemy
+ * from the same side reuse them without any navmesh query. A cached point is only served once a few of them were
+ * found near the search origin, and each hit picks one of them at random, so that these bots don't converge.
+ */
+UCLASS()
+class UShooterNavQueryBatcher : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** batcher of the world, null if it's disabled (p.ShooterNavQueryBatcher 0) */
+	static UShooterNavQueryBatcher* Get(const UObject* WorldContextObject);
+
+	/** random one of the recent reachable points found for Querier near SearchOrigin around Enemy, if there are enough */
+	bool FindCachedPoint(const AController* Querier, const AActor* Enemy, const FVector& SearchOrigin, FVector& OutPoint) const;
+
+	/** queues a reachable point query of Querier around SearchOrigin, returns its id for cancellation */
+	uint32 RequestPoint(const AController* Querier, const AActor* Enemy, const FVector& SearchOrigin, float SearchRadius, FShooterNavPointCallback&& OnComplete);
+
+	/** drops a queued request, its callback will never be called */
+	void CancelRequest(uint32 RequestId);
+
+private:
+
+	struct FRequest
+	{
+		uint32 Id;
+		FObjectKey Enemy;
+		FVector SearchOrigin;
+		float SearchRadius;
+		TWeakObjectPtr<ANavigationData> NavData;
+		FSharedConstNavQueryFilter QueryFilter;
+		FShooterNavPointCallback OnComplete;
+	};
+
+	struct FCachedPoint
+	{
+		FVector SearchOrigin;
+		FVector Point;
+		float Time;
+		/** points are only shared by queries on the same nav data and filter */
+		const ANavigationData* NavData;
+		const FNavigationQueryFilter* QueryFilter;
+	};
+
+	/** queued requests */
+	TArray<FRequest> Requests;
+
+	/** recent results by enemy */
+	TMap<FObjectKey, TArray<FCachedPoint>> Cache;
+
+	/** next request id, 0 is never used */
+	uint32 NextRequestId;
+
+	/** nav data and filter of Querier's queries */
+	bool GetNavQuery(const AController* Querier, ANavigationData*& OutNavData, FSharedConstNavQueryFilter& OutQueryFilter) const;
+
+	/** random cached point matching a query, if there are enough of them */
+	bool PickCachedPoint(const FObjectKey& Enemy, const FVector& SearchOrigin, const ANavigationData* NavData, const FNavigationQueryFilter* QueryFilter, FVector& OutPoint) const;
+
+	/** adds a result to the cache of an enemy */
+	void AddCachedPoint(const FObjectKey& Enemy, const FVector& SearchOrigin, const FVector& Point, const ANavigationData* NavData, const FNavigationQueryFilter* QueryFilter);
+};
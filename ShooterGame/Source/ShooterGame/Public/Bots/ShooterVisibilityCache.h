@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "ShooterVisibilityCache.generated.h"
+
+/**
+ * Per world cache of bot line of sight traces, shared by target selection, weapon LOS checks and behavior tree decorators.
+ *
+ * A query returns the last known result for a (viewer, target) pair, and schedules a refresh when it's older than
+ * p.ShooterVisibilityMaxAge. Refreshes are async weapon traces from the viewer's eyes to the target, and at most
+ * p.ShooterVisibilityTraceBudget of them are started per frame: priority pairs (a bot and its current enemy) go first,
+ * the rest wait in a FIFO queue, and requests nobody queried again within p.ShooterVisibilityMaxAge are dropped.
+ * A pair that has never been traced is traced synchronously on its first query, so it never reads as not visible.
+ */
+UCLASS()
+class UShooterVisibilityCache : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** cache of the world, null if it's disabled (p.ShooterVisibilityCache 0) */
+	static UShooterVisibilityCache* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Actor hit by the last weapon trace from Viewer's eyes to Target, null if nothing was hit.
+	 * Pairs without a result are traced right away. Returns false if Viewer or Target is null.
+	 *
+	 * @param bPriority	refresh this pair before the others, for the viewer's current enemy
+	 */
+	bool GetHitActor(APawn* Viewer, AActor* Target, AActor*& OutHitActor, bool bPriority = false);
+
+	/** number of cached pairs */
+	int32 GetNumEntries() const { return Entries.Num(); }
+
+private:
+
+	typedef TPair<FObjectKey, FObjectKey> FPairKey;
+
+	enum class ERefreshState : uint8
+	{
+		None,
+		Queued,
+		PriorityQueued,
+		InFlight,
+	};
+
+	struct FEntry
+	{
+		TWeakObjectPtr<APawn> Viewer;
+		TWeakObjectPtr<AActor> Target;
+		/** result of the last trace */
+		TWeakObjectPtr<AActor> HitActor;
+		/** world time of the last result, negative if there is none */
+		float ResultTime;
+		/** world time of the last query, for eviction */
+		float QueryTime;
+		/** refresh progress */
+		ERefreshState RefreshState;
+	};
+
+	/** cached pairs */
+	TMap<FPairKey, FEntry> Entries;
+
+	/** pairs waiting for a trace */
+	TArray<FPairKey> Requests;
+
+	/** pairs waiting for a trace, started before Requests */
+	TArray<FPairKey> PriorityRequests;
+
+	/** traces in flight, by trace user data */
+	TMap<uint32, FPairKey> PendingTraces;
+
+	/** user data of next trace */
+	uint32 NextTraceId;
+
+	/** world time of last eviction pass */
+	float LastEvictionTime;
+
+	FTraceDelegate TraceDelegate;
+
+	/** async trace result */
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Data);
+
+	/** starts queued traces, within the frame budget */
+	void StartTraces();
+
+	/** starts the traces of a queue, returns the number started */
+	int32 StartTraces(TArray<FPairKey>& Queue, ERefreshState QueuedState, int32 Budget);
+
+	/** weapon trace from Viewer's eyes to Target, as AShooterAIController::HasWeaponLOSToEnemy */
+	static void GetTraceParams(APawn* Viewer, AActor* Target, FVector& OutStart, FVector& OutEnd, FCollisionQueryParams& OutParams);
+};
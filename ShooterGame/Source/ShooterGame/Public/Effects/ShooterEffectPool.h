@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ShooterEffectPool.generated.h"
+
+class AShooterImpactEffect;
+class UParticleSystemComponent;
+class UDecalComponent;
+
+/**
+ * Per world pool of weapon FX: impact effect actors, particle components (trails, impacts) and decals.
+ *
+ * Instead of spawning a new actor or component for every shot, finished ones are reused.
+ * Pools are capped by p.ShooterFXPoolParticles (per particle template) and p.ShooterFXPoolDecals:
+ * when every entry is in use, the least recently used one is restarted.
+ * Spawns avoided are reported in stat ShooterFX.
+ */
+UCLASS()
+class UShooterEffectPool : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** pool of the world, null if pooling is disabled (p.ShooterFXPool 0) */
+	static UShooterEffectPool* Get(const UObject* WorldContextObject);
+
+	/** plays an impact effect for Hit, reusing an effect actor of the same class */
+	void SpawnImpactEffect(TSubclassOf<AShooterImpactEffect> Template, const FHitResult& Hit, const FTransform& SpawnTransform);
+
+	/** plays a particle system at a location, reusing a finished component of the same template */
+	UParticleSystemComponent* SpawnEmitter(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation);
+
+	/** shows a decal for LifeSpan seconds, attached to a component, reusing an expired decal component */
+	UDecalComponent* SpawnDecal(UMaterialInterface* Material, const FVector& Size, USceneComponent* AttachTo, FName AttachBoneName, const FVector& Location, const FRotator& Rotation, float LifeSpan);
+
+private:
+
+	struct FPooledParticle
+	{
+		UParticleSystemComponent* Component;
+		double LastUseTime;
+	};
+
+	struct FPooledDecal
+	{
+		UDecalComponent* Component;
+		double LastUseTime;
+		double ExpireTime;
+	};
+
+	/** owner of pooled components */
+	UPROPERTY(Transient)
+	AActor* PoolActor;
+
+	/** impact effect actors, one per class: they only play FX synchronously */
+	UPROPERTY(Transient)
+	TMap<UClass*, AShooterImpactEffect*> ImpactEffects;
+
+	/** particle components, by template */
+	TMap<UParticleSystem*, TArray<FPooledParticle>> Particles;
+
+	/** decal components */
+	TArray<FPooledDecal> Decals;
+
+	/** creates the owner of pooled components if needed */
+	AActor* GetPoolActor();
+};
@@ -97,6 +97,9 @@ class AShooterImpactEffect : public AActor
 	/** spawn effect */
 	virtual void PostInitializeComponents() override;
 
+	/** plays particles, sound and decal for SurfaceHit at the actor location, pooled actors call it on every reuse */
+	void PlayEffect();
+
 protected:
 
 	/** get FX for material type */
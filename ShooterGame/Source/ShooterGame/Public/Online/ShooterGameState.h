@@ -5,6 +5,8 @@
 #include "ShooterOnlineGameMatches.h"
 #include "ShooterGameState.generated.h"
 
+class AShooterProjectile;
+
 /** ranked PlayerState map, created from the GameState */
 typedef TMap<int32, TWeakObjectPtr<AShooterPlayerState> > RankedPlayerMap; 
 
@@ -39,6 +41,18 @@ public:
 	virtual void HandleMatchHasStarted() override;
 	virtual void HandleMatchHasEnded() override;
 
+	/**
+	 * [server -> everyone] a simulated projectile has been fired, see p.ShooterSimulatedProjectiles.
+	 * Simulated projectile events go through the always relevant game state: a client can see a projectile,
+	 * or its explosion, without the firing weapon being relevant to it, and the weapon can be destroyed mid-flight.
+	 */
+	UFUNCTION(unreliable, NetMulticast)
+	void MulticastSimulatedProjectileFired(TSubclassOf<AShooterProjectile> ProjectileClass, FVector_NetQuantize Origin, FVector_NetQuantizeNormal ShootDir, uint16 ProjectileId, float ProjectileLife);
+
+	/** [server -> everyone] a simulated projectile exploded */
+	UFUNCTION(reliable, NetMulticast)
+	void MulticastSimulatedProjectileExploded(TSubclassOf<AShooterProjectile> ProjectileClass, uint16 ProjectileId, FVector_NetQuantize ImpactPoint, FVector_NetQuantizeNormal ImpactNormal);
+
 protected:
 	UPROPERTY(config)
 	FString ActivityId;
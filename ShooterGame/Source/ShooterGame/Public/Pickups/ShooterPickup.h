@@ -16,6 +16,9 @@ class AShooterPickup : public AActor
 	/** check if pawn can use this pickup */
 	virtual bool CanBePickedUp(class AShooterCharacter* TestPawn) const;
 
+	/** is it ready for interactions? */
+	bool IsActive() const { return bIsActive; }
+
 protected:
 	/** initial setup */
 	virtual void BeginPlay() override;
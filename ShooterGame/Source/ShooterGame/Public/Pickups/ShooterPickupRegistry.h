@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterPickupRegistry.generated.h"
+
+class AShooterPickup;
+class AShooterCharacter;
+
+/**
+ * Per world registry of pickups on the server, keyed by pickup class.
+ *
+ * Pickups of each class are stored in a static kd-tree (pickups don't move), and every node counts the available
+ * pickups in its subtree. Picking up and respawning only update counts on the path to the root, and nearest queries
+ * skip subtrees without available pickups, so both are O(log n).
+ * All pickups of a class share their type (ammo weapon, health...), so a single CanBePickedUp check per class
+ * tells whether a pawn can use any of them.
+ */
+UCLASS()
+class UShooterPickupRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** registry of the world, null if it's disabled (p.ShooterPickupRegistry 0) */
+	static UShooterPickupRegistry* Get(const UObject* WorldContextObject);
+
+	/** adds a pickup, on the server */
+	void RegisterPickup(AShooterPickup* Pickup);
+
+	/** pickup has been picked up or has respawned */
+	void SetAvailable(AShooterPickup* Pickup, bool bAvailable);
+
+	/**
+	 * Nearest available pickup that Pawn can use, among pickup classes accepted by TypeFilter.
+	 * With bUsePathCost, the closest candidates are ranked by navigation path cost instead of straight line distance.
+	 */
+	AShooterPickup* FindNearestPickup(AShooterCharacter* Pawn, const FVector& Location, TFunctionRef<bool(AShooterPickup*)> TypeFilter, bool bUsePathCost = false);
+
+private:
+
+	struct FNode
+	{
+		TWeakObjectPtr<AShooterPickup> Pickup;
+		FVector Location;
+		/** splitting axis */
+		int32 Axis;
+		/** parent node, INDEX_NONE for the root */
+		int32 Parent;
+		/** subtrees are [Begin, Index) and (Index, End) */
+		int32 Begin;
+		int32 End;
+		/** available pickups in the subtree, this node included */
+		int32 NumAvailable;
+		bool bAvailable;
+	};
+
+	struct FPickupTree
+	{
+		/** tree nodes, each subtree is a contiguous range with its root in the middle */
+		TArray<FNode> Nodes;
+		/** registered pickups, the tree is rebuilt from them when bDirty */
+		TArray<TWeakObjectPtr<AShooterPickup>> Pickups;
+		/** node of each pickup */
+		TMap<AShooterPickup*, int32> NodeIndices;
+		bool bDirty = false;
+	};
+
+	/** trees by pickup class */
+	TMap<UClass*, FPickupTree> Trees;
+
+	/** rebuilds a tree after registrations */
+	void BuildTree(FPickupTree& Tree);
+
+	/** builds nodes in [Begin, End), returns the subtree root */
+	int32 BuildNode(FPickupTree& Tree, int32 Begin, int32 End, int32 Parent);
+
+	/** up to MaxCount nearest available nodes, nearest first */
+	void FindNearest(const FPickupTree& Tree, const FVector& Location, int32 MaxCount, TArray<TPair<float, int32>, TInlineAllocator<8>>& OutNearest) const;
+	void FindNearestInNode(const FPickupTree& Tree, int32 NodeIndex, const FVector& Location, int32 MaxCount, TArray<TPair<float, int32>, TInlineAllocator<8>>& OutNearest) const;
+};
@@ -492,9 +492,27 @@ protected:
 private:
 	
 	/*Maximum jetpack energy*/
-	UPROPERTY(EditAnywhere, Replicated, meta = (ClapMin = "0", ClapMax = "10000"), Category = "Jetpack")
+	UPROPERTY(EditAnywhere, meta = (ClapMin = "0", ClapMax = "10000"), Category = "Jetpack")
 		double JetpackEnergy = 100;
 
+	/*
+	* Replicated JetpackEnergy. The server only updates it when the energy rate changes
+	* (sprint start/stop, empty, full), and the owner extrapolates the value between updates.
+	*/
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_JetpackEnergySegment)
+		FShooterJetpackEnergySegment JetpackEnergySegment;
+
+	/*Owner rebuilds JetpackEnergy from the new segment*/
+	UFUNCTION()
+		void OnRep_JetpackEnergySegment();
+
+	/*[server] Starts a new JetpackEnergySegment if the energy rate changed*/
+	void UpdateJetpackEnergySegment();
+
+	/*CharacterMovement, already cast to UShooterCharacterMovement. It's set in PostInitializeComponents()*/
+	UPROPERTY(Transient)
+		class UShooterCharacterMovement* ShooterCharacterMovement;
+
 
 public:
 
@@ -534,8 +552,6 @@ public:
 	void WallRunChangeState();
 	/*Makes actor jump in view direction after a WallRun*/
 	void WallRunJump();
-	/*Performs WallRun actor movement*/
-	void WallRunMoveToNewPosition();
 	/*Computes initial WallRun movement direction*/
 	void WallRunComputeMovementDirection();
 	/*Computes next grip point on a surface for WallRunning*/
@@ -544,6 +560,9 @@ public:
 	void WallRunSetEndingMovement();
 	
 
+	/*CharacterMovement as UShooterCharacterMovement, without any dynamic cast*/
+	FORCEINLINE class UShooterCharacterMovement* GetShooterCharacterMovement() const { return ShooterCharacterMovement; }
+
 	/*JetpackEnergy getter*/
 	float GetJetpackEnergy() const;
 	/*JetpackEnergy setter*/
@@ -9,6 +9,177 @@
 
 #define MOVE_WallRunning MOVE_Custom
 
+/**
+* Compact record of a WallRun grip point on a wall.
+* It's stored instead of a full FHitResult, both in the movement component
+* and in every saved move kept for client prediction.
+*/
+struct FShooterWallGripPoint
+{
+public:
+
+	FShooterWallGripPoint();
+	/*Quantizes ImpactPoint, ImpactNormal and Component of a wall hit*/
+	explicit FShooterWallGripPoint(const FHitResult& Hit);
+
+	/*Grip point on the wall collider*/
+	FVector GetImpactPoint() const;
+	/*Wall surface normal at the grip point*/
+	FVector GetImpactNormal() const;
+	/*Gripped wall component, if it's still valid*/
+	UPrimitiveComponent* GetComponent() const;
+
+	/*Resolution of the quantized grip point, in cm*/
+	static constexpr float ImpactPointResolution = 0.5f;
+	/*Bits of each grip point coordinate. With the resolution above, they cover +/- 5.2 km*/
+	static constexpr int32 ImpactPointBits = 21;
+
+private:
+
+	/*Grip point, three signed ImpactPointBits integers in ImpactPointResolution units, packed in 64 bits*/
+	uint64 PackedImpactPoint;
+	/*Normal components, scaled to the int16 range*/
+	int16 QuantizedNormal[3];
+	/*Optional gripped wall component*/
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+};
+
+/*One ray of the async wall probe, see UShooterCharacterMovement::SubmitWallProbeAsync()*/
+struct FShooterWallProbeRay
+{
+	FVector Start;
+	FVector End;
+	/*Static wall found by UShooterWallRunIndex. When the index covers the ray, the pawn trace only hits movable bodies, up to this wall*/
+	FHitResult StaticHit;
+	/*ECC_Pawn trace, for the grip point*/
+	FTraceHandle PawnHandle;
+	/*ECC_Visibility trace along the same ray, see UShooterCharacterMovement::IsWallVisibleAlongRay()*/
+	FTraceHandle VisibilityHandle;
+};
+
+
+/**
+* Movement abilities handled by the UShooterCharacterMovement ability registry.
+* Each ability owns one bit in the trigger and availability masks,
+* and bits match FShooterCharacterNetworkMoveData::AbilityInputFlags.
+*/
+enum class EShooterMovementAbility : uint8
+{
+	Teleport,
+	WallJump,
+	JetpackSprint,
+	WallRun,
+	WallRunJump,
+	Count
+};
+
+/*Static description of a movement ability, see UShooterCharacterMovement::GetAbilityDesc()*/
+struct FShooterMovementAbilityDesc
+{
+	/*Ability name, used by stats and reports*/
+	const TCHAR* Name;
+	/*Performed by PerformMovement, both for new and replayed moves, when the ability is triggered*/
+	void (*OnTriggered)(class AShooterCharacter& ShooterCharacter, class UShooterCharacterMovement& CharMov);
+	/*Performed by PerformMovement for every move, whether the ability is triggered or not*/
+	void (*OnTick)(class AShooterCharacter& ShooterCharacter, class UShooterCharacterMovement& CharMov, float DeltaTime);
+	/*One-shot actions clear their trigger once performed, held actions keep it until they are released*/
+	bool bConsumeTrigger;
+	/*Triggers that take priority over this ability, which is ignored while any of them is set*/
+	uint8 SuppressedByMask;
+	/*Availability bits that are cleared while this ability is triggered, and restored when it's released*/
+	uint8 DisablesMask;
+};
+
+/**
+* Client prediction cost counters of a single character, accumulated since spawn.
+* They are also reported per frame in stat ShooterMovement and in CSV profiles,
+* see ShooterMovement.DumpReplayStats
+*/
+struct FShooterMovementReplayStats
+{
+	/*[client] Corrections received for moves where each ability was triggered*/
+	uint32 CorrectionsPerAbility[(uint8)EShooterMovementAbility::Count];
+	/*[client] Corrections received for moves without any triggered ability*/
+	uint32 CorrectionsWithoutAbility;
+	/*[client] Number of times saved moves were replayed after a correction*/
+	uint32 Replays;
+	/*[client] Total number of replayed saved moves*/
+	uint32 ReplayedMoves;
+	/*[client] Total CPU time spent replaying saved moves*/
+	double ReplaySeconds;
+	/*[server] Moves where the ability state predicted by the client was different from the server one*/
+	uint32 ServerStateMismatches;
+	/*[client] Corrections where the server location could be compared with the client one*/
+	uint32 MeasuredCorrections;
+	/*[client] Sum and max distance between the server location of a corrected move and the client location for the same move,
+	* as predicted or last replayed*/
+	double CorrectionErrorSum;
+	float MaxCorrectionError;
+
+	FShooterMovementReplayStats();
+};
+
+
+/**
+* Move data sent to the server for every move.
+* Ability requests and ability state are serialized explicitly here,
+* instead of being multiplexed into the custom compressed flags bits.
+*/
+struct FShooterCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+public:
+
+	/*Ability requests, one bit for each action*/
+	enum AbilityInputFlags
+	{
+		INPUT_Teleport = 0x01,
+		INPUT_WallJump = 0x02,
+		INPUT_JetpackSprint = 0x04,
+		INPUT_WallRun = 0x08,
+		INPUT_WallRunJump = 0x10,
+	};
+	static const int32 AbilityInputBits = 5;
+
+	/*Predicted ability state at the beginning of the move, one bit for each state*/
+	enum AbilityStateFlags
+	{
+		STATE_CanTeleport = 0x01,
+		STATE_CanWallJump = 0x02,
+		STATE_CanJetpackSprint = 0x04,
+		STATE_CanWallRun = 0x08,
+		STATE_WallRunFlowing = 0x10,
+		STATE_WallRunJumpOnce = 0x20,
+	};
+	static const int32 AbilityStateBits = 6;
+
+	/*Bit-packed AbilityInputFlags*/
+	uint8 AbilityInputs;
+	/*Bit-packed AbilityStateFlags*/
+	uint8 AbilityState;
+
+	FShooterCharacterNetworkMoveData();
+
+	/*Packs ability availability bits and WallRun state as AbilityStateFlags*/
+	static uint8 PackAbilityState(uint8 AbilityAvailable, bool bWallRunFlowing, bool bWallRunJumpOnce);
+
+	/*Fills ability data from a FSavedMove_Character_Upgraded*/
+	void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	/*Serializes ability data after default move data, using only the needed bits*/
+	bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+/*Provides FShooterCharacterNetworkMoveData for new, pending and old moves*/
+struct FShooterCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+public:
+
+	FShooterCharacterNetworkMoveDataContainer();
+
+private:
+
+	FShooterCharacterNetworkMoveData ShooterMoveData[3];
+};
+
 UCLASS()
 class UShooterCharacterMovement : public UCharacterMovementComponent
 {
@@ -16,28 +187,20 @@ class UShooterCharacterMovement : public UCharacterMovementComponent
 
 private:
 
-	/*Has the player requested a Teleport action?*/
-	bool bTriggeringTeleport;
-	/*Has the player requested a WallJump action?*/
-	bool bTriggeringWallJump;
-	/*Is the player requesting a JetpackSprint action?*/
-	bool bTriggeringJetpackSprint;
-	/*Is the player requesting a WallRun action?
-	* This variable is set to true for both requests*/
-	bool bTriggeringWallRun;
-	/*Is the player requesting a WallRunJump action?*/
-	bool bTriggeringWallRunJump;
-	
-	/*Teleport action current availability*/
-	bool bCanTeleport;
-	/*WallJump action current availability
-	*This is an additional parameter, different from the player state in space.
-	*See GetCanWallJump()*/
-	bool bCanWallJump;
-	/*JetpackSprint action current availability*/
-	bool bCanJetpackSprint;
-	/*WallRun action current availability*/
-	bool bCanWallRun;
+	/*CharacterOwner, already cast to AShooterCharacter. It's updated by SetUpdatedComponent()*/
+	UPROPERTY(Transient)
+		class AShooterCharacter* ShooterCharacterOwner;
+
+	/**
+	* Requested actions, one bit for each EShooterMovementAbility.
+	* WallRun bit is set for both WallRun start and stop requests.
+	*/
+	uint8 AbilityTriggers;
+	/**
+	* Actions current availability, one bit for each EShooterMovementAbility.
+	* This is an additional condition, different from the player state in space: see CanWallJump() for instance.
+	*/
+	uint8 AbilityAvailable;
 
 	/*Stores Maximum ending time for WallRun, according to WallRunMaxDuration*/
 	double WallRunMaxEndingTime;
@@ -50,12 +213,39 @@ private:
 	* without touching the floor.*/
 	bool bWallRunFlowing;
 	/*Stored information about last grip point on an object*/
-	FHitResult WallRunLastHitPoint;
+	FShooterWallGripPoint WallRunLastGripPoint;
 	/*Vector storing WallRun instantaneous flowing direction.
 	*It's constantly updated*/
 	FVector WallRunFlowingDirection;
 	
 
+	/*Network move data container, see FShooterCharacterNetworkMoveData*/
+	FShooterCharacterNetworkMoveDataContainer ShooterNetworkMoveDataContainer;
+	/*Has the server found a different ability state from the one predicted by the client, in the current move?*/
+	bool bAbilityStateMismatch;
+	/*Prediction cost counters, see GetReplayStats()*/
+	FShooterMovementReplayStats ReplayStats;
+
+	/*Client time stamp of the move being processed by MoveAutonomous*/
+	float CurrentMoveTimeStamp;
+	/*Is CurrentMoveTimeStamp the one of the move being performed? It's only set during MoveAutonomous*/
+	bool bMoveTimeStampValid;
+	/*[server] Client time stamp of the last move that requested one-shot actions, used to never execute them twice*/
+	float LastOneShotTimeStamp;
+	/*Cached result of the last Teleport destination query, see ResolveTeleportDestination()*/
+	FVector TeleportQueryDesired;
+	FVector TeleportQueryResolved;
+	bool bTeleportQueryValid;
+	/*World time of the cached Teleport destination query, 0 if none*/
+	float TeleportQueryTime;
+	/*Teleport resolutions of this character in the current one second window, and in the last complete one*/
+	uint32 TeleportResolutionsInWindow;
+	uint32 TeleportResolutionsLastWindow;
+	/*World real time when the current Teleport resolutions window started*/
+	float TeleportResolutionsWindowStart;
+	/*Rolls the Teleport resolutions window over every second, and updates this character's share of the stat*/
+	void UpdateTeleportResolutionsStat();
+
 	/*Number of rays to be cast when checking for collisions all around*/
 	uint8 WallRunWallDetectionRayNumber = 12;
 
@@ -77,9 +267,73 @@ private:
 	* This is a custom version of the LineTraceSingleByChannel.
 	* It casts RaysNumber rays around the player, all laying on the same XY-plane.
 	* Hit informations returned are about the nearest hit, 
-	* and it also checks that a visible object is present in that direction.
+	* and it also checks that there is a visible object along the ray (see IsWallVisibleAlongRay()).
 	*/
 	bool CircleTraceSingleByChannel(struct FHitResult& OutHit, const FVector& Start, const FVector& End, uint8 RaysNumber) const;
+	/**
+	* Same result as the synchronous CircleTraceSingleByChannel rays, with a single ECC_Pawn overlap of the ring radius.
+	* Each ray is then traced against the overlapped bodies only, and against UShooterWallRunIndex when it covers the ring.
+	* A second overlap, on ECC_Visibility, is only done if a grip collider doesn't block visibility.
+	*/
+	bool CircleTraceByOverlap(struct FHitResult& OutHit, const FVector& Start, const FVector& ForwardRay, uint8 RaysNumber, const FCollisionQueryParams& Params) const;
+
+
+	/*Async wall probe rays submitted last frame*/
+	TArray<FShooterWallProbeRay> WallProbeRays;
+	/*Ray start and forward ray of the async wall probe submitted last frame*/
+	FVector WallProbeStart;
+	FVector WallProbeForwardRay;
+	/*Nearest grip point found by the last consumed async wall probe*/
+	FHitResult WallProbeHit;
+	/*Did the last consumed async wall probe find a grip point?*/
+	bool bWallProbeHit;
+	/*Frame counter value when the last async wall probe was consumed, 0 if none is available*/
+	uint64 WallProbeResultFrame;
+
+	/**
+	* MOVE_WallRunning physics.
+	* The player is swept in front of the next grip point on the wall, instead of being teleported,
+	* and Velocity follows the actual movement so that simulated proxies can interpolate it.
+	*/
+	void PhysWallRunning(float deltaTime, int32 Iterations);
+	/**
+	* PhysWallRunning with bFixedAbilitySubsteps: a new grip point is computed on each substep boundary,
+	* and the player is interpolated towards it until the next boundary,
+	* so that the path along the wall doesn't depend on the frame rate.
+	*/
+	void PhysWallRunningSubstepped(float deltaTime, int32 Iterations);
+
+	/*Local substep clock, for moves without a client time stamp (standalone, listen server host)*/
+	float AbilitySubstepClock;
+	/*Has a substep boundary been crossed since WallRunning physics last advanced?*/
+	bool bWallRunSubstepPending;
+	/*Time left until the next substep boundary, at the start of the current WallRunning physics segment*/
+	float WallRunSubstepTimeLeft;
+	/**
+	* Start time of the current move on the substep clock.
+	* It's the client time stamp whenever the move has one: client and server share it,
+	* so both find the same substep boundaries whatever their frame rate and however moves are combined.
+	*/
+	float GetAbilitySubstepWindowStart(float DeltaTime);
+	/*PerformMovement with bFixedAbilitySubsteps: the move is split on substep boundaries, and ability OnTick hooks run on each of them*/
+	void PerformSubsteppedMovement(class AShooterCharacter& ShooterCharacter, float DeltaTime);
+
+	/*Should the async wall probe run this frame? Only for locally controlled pawns, while a WallRun could actually be started*/
+	bool ShouldProbeWallAsync() const;
+	/**
+	* Submits async pawn and visibility traces for each CircleTraceSingleByChannel ray, from the position the next move starts from.
+	* Static walls come from UShooterWallRunIndex when it's available, then pawn traces only hit movable bodies.
+	* Results are available on next frame, see ConsumeWallProbeAsync()
+	*/
+	void SubmitWallProbeAsync();
+	/*Reads the async traces submitted last frame and stores the nearest grip point*/
+	void ConsumeWallProbeAsync();
+	/**
+	* Can CircleTraceSingleByChannel use the async wall probe result?
+	* Only for the live move of a locally controlled pawn, starting exactly where the probe was cast from.
+	* Replayed moves and moves received by the server always trace synchronously.
+	*/
+	bool CanUseWallProbeResult(const FVector& Start, const FVector& ForwardRay) const;
 
 public:
 
@@ -105,6 +359,17 @@ public:
 		float WallJumpResponseImpulseIntensity = 20000;
 
 
+	/**
+	* Ability forces (JetpackSprint) and WallRun advance are integrated with fixed substeps of AbilitySubstepTime
+	* instead of the move DeltaTime, so that clients at different frame rates predict the same result as the server.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
+		bool bFixedAbilitySubsteps = false;
+	/*Fixed ability substep duration, in seconds*/
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.004", ClampMax = "0.1", EditCondition = "bFixedAbilitySubsteps"), Category = "Abilities")
+		float AbilitySubstepTime = 1.f / 60.f;
+
+
 	/*Force that pushes the actor upward*/
 	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0", ClampMax = "100000"), Category = "JetpackSprint")
 		float JetpackUpwardAcceleration = 3000;
@@ -145,64 +410,98 @@ public:
 
 	virtual float GetMaxSpeed() const override;
 
+	/**
+	* WallRun grip points are found with an ECC_Pawn trace, and the wall must be visible: an ECC_Visibility trace
+	* along the same ray must hit something too. The visible object can be different from the grip collider,
+	* for instance a visible mesh with a simpler invisible collider in front of it.
+	* When the grip collider blocks ECC_Visibility itself, which is the usual case, the visibility trace would hit
+	* at least the same collider, so it's skipped.
+	*/
+	static bool IsWallVisibleAlongRay(UWorld* World, const FHitResult& GripHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params);
+	/*Counts wall traces cast by ability code, for stat ShooterMovement and benchmarks. Game thread only*/
+	static void CountWallTraces(uint32 Count);
+	/*Wall traces cast by ability code since startup*/
+	static uint64 GetWallTraceCount();
+
+	/**Consumes the async wall probe before the regular movement tick, and submits a new one after it, when enabled.*/
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/**Removes this character's Teleport resolutions from the stat.*/
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/**Handles MOVE_WallRunning, see PhysWallRunning()*/
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+
+	/**Caches ShooterCharacterOwner too, so that ability code never has to cast CharacterOwner.*/
+	virtual void SetUpdatedComponent(USceneComponent* NewUpdatedComponent) override;
+
+	/*CharacterOwner as AShooterCharacter, without any dynamic cast*/
+	FORCEINLINE class AShooterCharacter* GetShooterCharacterOwner() const { return ShooterCharacterOwner; }
+
+	/**Keeps track of the client time stamp of the move being performed.*/
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
+
 	/**Locally performs the movement.*/
 	void PerformMovement(float DeltaTime) override;
-	/**Updates local state from flags stored in a SavedMove.*/
+	/**Updates local state from flags stored in a SavedMove.
+	* On the server, it also applies ability requests from the current FShooterCharacterNetworkMoveData.*/
 	void UpdateFromCompressedFlags(uint8 Flags) override;
 	/** Allocates my custom FNetworkPredictionData_Client_Character_Upgraded,
 	* Instead of the default FNetworkPredictionData_Client_Character*/
 	class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
-
+	/**[client] Measures the cost of replaying saved moves after a correction.*/
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+	/**[client] Attributes each correction to the abilities triggered in the corrected move, and measures how far the client was.*/
+	virtual void OnClientCorrectionReceived(class FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+	/*Prediction cost counters getter*/
+	FORCEINLINE const FShooterMovementReplayStats& GetReplayStats() const { return ReplayStats; }
+	/*Clears prediction cost counters, e.g. between test phases*/
+	FORCEINLINE void ResetReplayStats() { ReplayStats = FShooterMovementReplayStats(); }
+
+
+	/*Ability registry entry, indexed by EShooterMovementAbility*/
+	static const FShooterMovementAbilityDesc& GetAbilityDesc(EShooterMovementAbility Ability);
+	/*Bit of an ability in the trigger and availability masks*/
+	static FORCEINLINE uint8 GetAbilityBit(EShooterMovementAbility Ability) { return (uint8)(1 << (uint8)Ability); }
+	/*Bits of all the one-shot abilities, see FShooterMovementAbilityDesc::bConsumeTrigger*/
+	static uint8 GetOneShotAbilityMask();
 
 	/**
-	* These action state getters and setters also enable/disable incompatible actions
-	**/
-	/* Teleport request state getter*/
-	bool GetTriggeringTeleport() const;
-	/* Teleport request state setter*/
-	void SetTriggeringTeleport(bool bTriggeringTeleport);
-	/* WallJump request state getter*/
-	bool GetTriggeringWallJump() const;
-	/* WallJump request state setter*/
-	void SetTriggeringWallJump(bool bTriggeringWallJump);
-	/* JetpackSprint request state getter*/
-	bool GetTriggeringJetpackSprint() const;
-	/* JetpackSprint request state setter*/
-	void SetTriggeringJetpackSprint(bool bTriggeringJetpackSprint);
-	/* WallRunStart or WallRunStop request state getter*/
-	bool GetTriggeringWallRun() const;
-	/* WallRunStart or WallRunStop request state setter*/
-	void SetTriggeringWallRun(bool bTriggeringWallRun);
-	/* WallRunJump request state getter*/
-	bool GetTriggeringWallRunJump() const;
-	/* WallRunJump request state setter*/
-	void SetTriggeringWallRunJump(bool bTriggeringWallRunJump);
-
-
-	/*Teleport action current availability getter*/
-	bool GetCanTeleport() const;
-	/*WallJump action current availability getter*/
-	bool GetCanWallJump() const;
-	/*JetpackSprint action current availability getter*/
-	bool GetCanJetpackSprint() const;
-	/*WallRun action current availbility getter*/
-	bool GetCanWallRun();
-	/*Teleport action current availability setter*/
-	void SetCanTeleport(bool bCanTeleport);
-	/*WallJump action current availability setter*/
-	void SetCanWallJump(bool bCanWallJump);
-	/*JetpackSprint action current availability setter*/
-	void SetCanJetpackSprint(bool bCanJetpackSprint);
-	/*WallRun action current availability setter*/
-	void SetCanWallRun(bool bCanWallRun);
+	* Action request state getter.
+	* An ability suppressed by another triggered ability is not considered triggered.
+	*/
+	bool IsTriggering(EShooterMovementAbility Ability) const;
+	/**
+	* Action request state setter.
+	* It also enables/disables incompatible actions, see FShooterMovementAbilityDesc::DisablesMask
+	*/
+	void SetTriggering(EShooterMovementAbility Ability, bool bTriggering);
+	/*Action current availability getter*/
+	bool IsAvailable(EShooterMovementAbility Ability) const;
+	/*Action current availability setter*/
+	void SetAvailable(EShooterMovementAbility Ability, bool bAvailable);
+
+	/*Raw trigger mask getter, as stored in saved moves*/
+	FORCEINLINE uint8 GetAbilityTriggers() const { return AbilityTriggers; }
+	/*Raw trigger mask setter, without side effects on availability*/
+	FORCEINLINE void SetAbilityTriggers(uint8 Triggers) { AbilityTriggers = Triggers; }
+	/*Raw availability mask getter, as stored in saved moves*/
+	FORCEINLINE uint8 GetAbilityAvailable() const { return AbilityAvailable; }
+	/*Raw availability mask setter*/
+	FORCEINLINE void SetAbilityAvailable(uint8 Available) { AbilityAvailable = Available; }
 
 	/**
-	* Following functions are also based on "bCan....." parameters,
+	* Following functions are also based on ability availability bits,
 	* but they can have additional conditions too.
 	*/
 
 	/*Teleport action current availability*/
 	bool CanTeleport() const;
+	/**
+	* Finds an obstacle free Teleport destination near Desired, with a capsule overlap test.
+	* The result is cached, so replaying the same move doesn't query the world again.
+	*/
+	bool ResolveTeleportDestination(const FVector& Desired, FVector& OutDestination);
 	/*WallJump action current availability*/
 	bool CanWallJump() const;
 	/*JetpackSprint action current availability*/
@@ -226,19 +525,27 @@ public:
 	bool GetWallRunJumpOnce() const;
 	/*WallRunJumpOnce setter*/
 	void SetWallRunJumpOnce(bool bWallRunJumpOnce);
+	/*Ability state packed as FShooterCharacterNetworkMoveData::AbilityStateFlags*/
+	uint8 GetPackedAbilityState() const;
+
 	/*WallRunFlowing getter*/
 	bool GetWallRunFlowing() const;
 	/*WallRunFlowing setter*/
 	void SetWallRunFlowing(bool bWallRunFlowing);
-	/*WallRunLastHitPoint getter*/
-	const FHitResult* GetWallRunLastHitPoint() const;
-	/*WallRunLastHitPoint setter*/
-	void SetWallRunLastHitPoint(FHitResult WallRunLastHitPoint);
+	/*WallRunLastGripPoint getter*/
+	const FShooterWallGripPoint& GetWallRunLastGripPoint() const;
+	/*WallRunLastGripPoint setter*/
+	void SetWallRunLastGripPoint(const FShooterWallGripPoint& WallRunLastGripPoint);
 	/*WallRunFlowingDirection getter*/
 	FVector GetWallRunFlowingDirection() const;
 	/*WallRunFlowingDirection setter*/
 	void SetWallRunFlowingDirection(FVector WallRunFlowingDirection);
 
+	/*Are ability forces integrated with fixed substeps? See bFixedAbilitySubsteps*/
+	FORCEINLINE bool IsUsingFixedAbilitySubsteps() const { return bFixedAbilitySubsteps; }
+	/*Fixed ability substep duration, never below MIN_TICK_TIME*/
+	float GetAbilitySubstepTime() const;
+
 	/*This works as an override in order to handle MOVE_WallRunning too*/
 	void SetMovementMode(EMovementMode NewMovementMode);
 
@@ -253,38 +560,10 @@ class FSavedMove_Character_Upgraded : public FSavedMove_Character
 {
 public:
 
-	enum CompressedFlagsExtended
-	{
-		FLAG_JumpPressed = 0x01,	// Jump pressed 
-		FLAG_WantsToCrouch = 0x02,	// Wants to crouch 
-		FLAG_Reserved_1 = 0x04,	// Reserved for future use 
-		FLAG_Reserved_2 = 0x08,	// Reserved for future use 
-		// Remaining bit masks are available for custom flags. 
-		FLAG_TriggeringTeleport = 0x10,
-		FLAG_TriggeringWallJump = 0x20,
-		FLAG_TriggeringJetpackSprint_WallRunJump = 0x40,	//this is used for both JetpackSprint and WallRunJump, that are mutually exclusive actions
-		FLAG_TriggeringWallRun_WallRunJump = 0x80,	//this is used for both WallRun and WallRunJump, that are mutually exclusive actions
-	};
-
-	/*Stores bTriggeringTeleport value*/
-	bool bSavedMove_TriggeringTeleport;
-	/*Stores bTriggeringWallJump value*/
-	bool bSavedMove_TriggeringWallJump;
-	/*Stores bTriggeringJetpackSprint value*/
-	bool bSavedMove_TriggeringJetpackSprint;
-	/*Stores bTriggeringWallRun value*/
-	bool bSavedMove_TriggeringWallRun;
-	/*Stores bTriggeringWallRunJump*/
-	bool bSavedMove_TriggeringWallRunJump;
-
-	/*Stores b value*/
-	bool bSavedMove_CanTeleport;
-	/*Stores bCanWallJump value*/
-	bool bSavedMove_CanWallJump;
-	/*Stores bCanJetpackSprint value*/
-	bool bSavedMove_CanJetpackSprint;
-	/*Stores bCanWalllRun value*/
-	bool bSavedMove_CanWallRun;
+	/*Stores AbilityTriggers value. New abilities don't need new fields*/
+	uint8 SavedMove_AbilityTriggers;
+	/*Stores AbilityAvailable value*/
+	uint8 SavedMove_AbilityAvailable;
 
 	/*Stores JetpackEnergy value*/
 	double SavedMove_JetpackEnergy;
@@ -296,8 +575,8 @@ public:
 	bool bSavedMove_WallRunJumpOnce;
 	/*Stores bWallRunFlowing value*/
 	bool bSavedMove_bWallRunFlowing;
-	/*Stores WallRunLastHitPoint value*/
-	FHitResult SavedMove_WallRunLastHitPoint;
+	/*Stores WallRunLastGripPoint value*/
+	FShooterWallGripPoint SavedMove_WallRunLastGripPoint;
 	/*Stores WallRunFlowingDirection value*/
 	FVector SavedMove_WallRunFlowingDirection;
 
@@ -305,15 +584,29 @@ public:
 
 	/* Clears SavedMove parameters */
 	void Clear() override;
-	/* Stores current action states from SavedMove into flags.
-	* It's the opposite of UpdateFromCompressedFlags */
-	uint8 GetCompressedFlags() const override;
+	/* Stores current action requests from SavedMove into FShooterCharacterNetworkMoveData::AbilityInputFlags.
+	* Action requests are not stored into compressed flags anymore */
+	uint8 GetAbilityInputs() const;
+	/* Stores current ability state from SavedMove into FShooterCharacterNetworkMoveData::AbilityStateFlags */
+	uint8 GetAbilityState() const;
 	/* Stores current action states from local state into SavedMove.
 	* Stored data will be used to replay actions if needed */
 	void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
 	/* Updates local action states from data stored in SavedMove */
 	void PrepMoveFor(class ACharacter* Character) override;
+	/* Moves with new action requests are important, and they are resent to the server until acknowledged */
+	bool IsImportantMove(const FSavedMovePtr& LastAckedMove) const override;
+	/* Steady moves (no one-shot actions, same held actions and same ability state)
+	* can be merged and sent to the server as a single ServerMove */
+	bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	/* Rolls ability state back to the beginning of OldMove, where the combined move starts from */
+	void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override;
+
+private:
 
+	/* Updates local ability state (availability, energy and WallRun state) from data stored in SavedMove.
+	* Action requests are not affected */
+	void RestoreAbilityStateFor(class AShooterCharacter* ShooterCharacter, class UShooterCharacterMovement* CharMov) const;
 };
 
 
@@ -0,0 +1,111 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterWallRunIndex.generated.h"
+
+class UBodySetup;
+
+/**
+* Vertical planar face of a static box collider, that wall traces could hit.
+*/
+struct FShooterWallSegment
+{
+	/*Face center*/
+	FVector Center;
+	/*Outward face normal, almost horizontal*/
+	FVector Normal;
+	/*Horizontal face direction*/
+	FVector Tangent;
+	/*Half face extent along Tangent*/
+	float HalfLength;
+	/*Half face extent along the up axis*/
+	float HalfHeight;
+	/*Collider owning this face*/
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	/*Instance owning this face for instanced meshes, INDEX_NONE otherwise*/
+	int32 Item;
+};
+
+/**
+* Per-level index of static walls, used by WallRun grip point detection instead of scene traces.
+*
+* Walls are the vertical faces of box colliders belonging to static components that block ECC_Pawn, and to each
+* instance of instanced meshes. They are extracted when the world begins play and when a streaming level is added,
+* and hashed on a 2D grid. Queries use scene traces until the index is built.
+* Static colliders that can't be represented as boxes (convex, complex, landscape...) mark their grid cells,
+* and queries crossing those cells fall back to a regular trace. Otherwise, only dynamic bodies are traced.
+*/
+UCLASS()
+class UShooterWallRunIndex : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/**
+	* Same result as a LineTraceSingleByChannel on ECC_Pawn, for WallRun grip point detection.
+	* It falls back to the scene trace when the index is disabled or not built yet.
+	*/
+	static bool LineTraceWall(UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params);
+
+	/**
+	* Static part of LineTraceWall(), without any scene query.
+	* Returns false if the index can't answer for this segment, which must then be traced against the whole scene.
+	* Otherwise OutHit is the nearest static wall, if OutHit.bBlockingHit, and only movable bodies are left to trace up to it.
+	*/
+	static bool RaycastStatic(UWorld* World, const FVector& Start, const FVector& End, FHitResult& OutHit);
+
+	/*Clears the index, queries use scene traces until the next build*/
+	void Invalidate();
+
+	/*Number of indexed wall faces, 0 until the index is built*/
+	int32 GetNumSegments() const { return Segments.Num(); }
+
+private:
+
+	/*Grid cell content*/
+	struct FCell
+	{
+		/*Indices in Segments of faces overlapping the cell*/
+		TArray<int32> SegmentIndices;
+		/*Is there any static collision that isn't indexed?*/
+		bool bHasUnindexedGeometry = false;
+	};
+
+	/*Indexed wall faces*/
+	TArray<FShooterWallSegment> Segments;
+	/*2D grid on the XY plane*/
+	TMap<FIntPoint, FCell> Cells;
+	/*Has the index been built for current levels?*/
+	bool bBuilt;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	/*Streaming levels change static collision*/
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+	/*Extracts wall faces from every static collider in the world*/
+	void Build();
+	/*Extracts wall faces from the static colliders of a level*/
+	void AddLevel(ULevel* Level, int32& OutNumIndexedComponents, int32& OutNumUnindexedComponents);
+	/*Adds the box elements of a static component, returns false if some collision couldn't be indexed*/
+	bool AddComponent(UPrimitiveComponent* Component);
+	/*Adds the box elements of a body at BodyTM, returns false and adds nothing if some collision couldn't be indexed*/
+	bool AddBody(UPrimitiveComponent* Component, const UBodySetup* BodySetup, const FTransform& BodyTM, int32 Item);
+	/*Adds a single vertical box face*/
+	void AddBoxFace(UPrimitiveComponent* Component, int32 Item, const FTransform& BoxTM, const FVector& LocalNormal, const FVector& LocalTangent, const FVector& HalfExtent);
+	/*Marks cells overlapping Bounds as not fully indexed*/
+	void MarkUnindexed(const FBox& Bounds);
+	/*Cell coordinates of a location*/
+	static FIntPoint GetCell(const FVector& Location);
+
+	/*Nearest indexed wall hit along the segment. bOutUnindexed is set if the segment crosses unindexed geometry*/
+	bool Raycast(const FVector& Start, const FVector& End, FHitResult& OutHit, bool& bOutUnindexed) const;
+};
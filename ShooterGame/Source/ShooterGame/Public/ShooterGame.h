@@ -21,6 +21,11 @@ class UBehaviorTreeComponent;
 DECLARE_LOG_CATEGORY_EXTERN(LogShooter, Log, All);
 DECLARE_LOG_CATEGORY_EXTERN(LogShooterWeapon, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("ShooterMovement"), STATGROUP_ShooterMovement, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("ShooterWeapon"), STATGROUP_ShooterWeapon, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("ShooterFX"), STATGROUP_ShooterFX, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("ShooterAI"), STATGROUP_ShooterAI, STATCAT_Advanced);
+
 /** when you modify this, please note that this information can be saved with instances
  * also DefaultEngine.ini [/Script/Engine.CollisionProfile] should match with this list **/
 #define COLLISION_WEAPON		ECC_GameTraceChannel1
@@ -159,4 +159,36 @@ public:
 	FDamageEvent& GetDamageEvent();
 	void SetDamageEvent(const FDamageEvent& DamageEvent);
 	void EnsureReplication();
-};
\ No newline at end of file
+};
+
+/** replicated jetpack energy, as a linear segment that the owner extrapolates locally */
+USTRUCT()
+struct FShooterJetpackEnergySegment
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Energy when the segment started */
+	UPROPERTY()
+	float Value;
+
+	/** Energy change per second: negative while sprinting, positive while recharging, 0 when idle */
+	UPROPERTY()
+	float Rate;
+
+	/** Server world time when the segment started */
+	UPROPERTY()
+	float ServerTime;
+
+	FShooterJetpackEnergySegment()
+		: Value(0.f)
+		, Rate(0.f)
+		, ServerTime(0.f)
+	{
+	}
+
+	/** Energy at a given server world time, clamped to [0, MaxValue] */
+	float Evaluate(float InServerTime, float MaxValue) const
+	{
+		return FMath::Clamp(Value + Rate * FMath::Max(0.f, InServerTime - ServerTime), 0.f, MaxValue);
+	}
+};
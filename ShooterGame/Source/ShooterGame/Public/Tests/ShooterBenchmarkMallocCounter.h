@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** The allocation counter only exists in non-shipping builds */
+#define WITH_SHOOTER_MALLOC_COUNTER !UE_BUILD_SHIPPING
+
+#if WITH_SHOOTER_MALLOC_COUNTER
+
+/**
+* Forwards every call to the engine allocator, and counts game thread allocations while enabled.
+* It's installed as GMalloc by the game module startup, only with -BenchmarkMallocCounter on the command line,
+* and never removed: blocks allocated through it can be freed at any time.
+*/
+class FShooterBenchmarkMallocCounter : public FMalloc
+{
+public:
+	/** installs the proxy if -BenchmarkMallocCounter is on the command line. Called once by the game module startup */
+	static void InstallIfRequested();
+
+	/** installed proxy, null without -BenchmarkMallocCounter */
+	static FShooterBenchmarkMallocCounter* Get() { return Instance; }
+
+	void SetCounting(bool bInCounting) { bCounting = bInCounting; }
+	uint64 GetNumAllocations() const { return NumAllocations; }
+	uint64 GetAllocatedBytes() const { return AllocatedBytes; }
+
+	// FMalloc interface
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override { CountAllocation(Count); return UsedMalloc->Malloc(Count, Alignment); }
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override { CountAllocation(Count); return UsedMalloc->TryMalloc(Count, Alignment); }
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override { CountAllocation(Count); return UsedMalloc->Realloc(Original, Count, Alignment); }
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override { CountAllocation(Count); return UsedMalloc->TryRealloc(Original, Count, Alignment); }
+	virtual void Free(void* Original) override { UsedMalloc->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return UsedMalloc->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return UsedMalloc->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { UsedMalloc->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { UsedMalloc->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { UsedMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { UsedMalloc->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { UsedMalloc->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { UsedMalloc->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { UsedMalloc->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return UsedMalloc->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return UsedMalloc->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return UsedMalloc->GetDescriptiveName(); }
+	// End of FMalloc interface
+
+private:
+	explicit FShooterBenchmarkMallocCounter(FMalloc* InUsedMalloc);
+
+	static FShooterBenchmarkMallocCounter* Instance;
+
+	FMalloc* UsedMalloc;
+	bool bCounting;
+	uint64 NumAllocations;
+	uint64 AllocatedBytes;
+
+	/** reallocations to 0 bytes are frees, they are not counted */
+	void CountAllocation(SIZE_T Count)
+	{
+		if (bCounting && Count > 0 && IsInGameThread())
+		{
+			NumAllocations++;
+			AllocatedBytes += Count;
+		}
+	}
+};
+
+#endif // WITH_SHOOTER_MALLOC_COUNTER
@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#pragma once
+
+#include "GauntletTestController.h"
+#include "Dom/JsonObject.h"
+#include "ShooterTestControllerBenchmark.generated.h"
+
+class AController;
+class AShooterCharacter;
+class AShooterGameMode;
+class APlayerStart;
+
+/**
+* Shared fixture of headless benchmarks and checks: settings from command line, bots spawned at player starts,
+* and a JSON report written before the test ends.
+*/
+UCLASS(Abstract)
+class UShooterTestControllerBenchmark : public UGauntletTestController
+{
+	GENERATED_BODY()
+
+protected:
+	// JSON report path, see InitOutputPath
+	FString OutputPath;
+
+	// Reads a setting from command line, Value is left unchanged if Param is not there
+	template<typename T>
+	static void ParseSetting(const TCHAR* Param, T& Value)
+	{
+		FParse::Value(FCommandLine::Get(), Param, Value);
+	}
+
+	// Reads the report path from command line, Saved/Automation/DefaultFileName by default
+	void InitOutputPath(const TCHAR* Param, const TCHAR* DefaultFileName);
+	// Game mode, once the game world is running and it can spawn bots
+	AShooterGameMode* GetReadyGameMode() const;
+	// Player starts of the loaded map. Ends the test and returns false if there is none
+	bool GetPlayerStarts(TArray<APlayerStart*>& OutPlayerStarts);
+	// Spawns a bot pawn possessed by a new ControllerClass, nullptr if it can't be spawned
+	AShooterCharacter* SpawnBot(AShooterGameMode* GameMode, const FVector& Location, const FRotator& Rotation, TSubclassOf<AController> ControllerClass);
+	// Logs and writes the report, then ends the test. It fails if bSuccess is false or the report can't be written
+	void WriteReportAndEndTest(const TSharedRef<FJsonObject>& Report, const TCHAR* ReportName, bool bSuccess = true);
+};
@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#pragma once
+
+#include "Tests/ShooterTestControllerBenchmark.h"
+#include "Dom/JsonValue.h"
+#include "ShooterTestControllerBotScaling.generated.h"
+
+class AShooterAIController;
+
+/**
+* Headless benchmark of bot target acquisition.
+* It adds bots in steps (BenchmarkBotCounts, 10 to 100 by default) and, at every step, makes each bot look for
+* its closest enemy and its closest visible enemy every frame, alternating frames with and without the enemy index (p.ShooterEnemyIndex).
+* Behavior trees are stopped, so only the queries are measured. Results are written as JSON to BenchmarkOutput
+* (Saved/Automation/BotScalingBenchmark.json by default).
+* The visibility cache (p.ShooterVisibilityCache) is off while queries run, unless -BenchmarkVisibilityCache is given.
+* Console variables are restored after each query pass.
+*/
+UCLASS()
+class UShooterTestControllerBotScaling : public UShooterTestControllerBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnInit() override;
+
+protected:
+	// Settings, from command line
+	TArray<int32> BotCounts;
+	int32 FramesPerMode;
+	bool bUseVisibilityCache;
+
+	// Benchmark state
+	UPROPERTY()
+	TArray<AShooterAIController*> Bots;
+	int32 StepIndex;
+	int32 StepFrame;
+	double QueryMs[2];
+	uint64 Traces[2];
+	int32 Frames[2];
+	TArray<TSharedPtr<FJsonValue>> StepResults;
+
+	virtual void OnTick(float TimeDelta) override;
+
+	// Spawns bots until there are Count of them, returns false if the game world is not ready yet
+	bool SpawnBots(int32 Count);
+	// Runs all bots queries with or without the index, returns elapsed milliseconds
+	double RunQueries(bool bUseIndex);
+	// Stores results of current step
+	void FinishStep();
+	// Writes the JSON report and ends the test
+	void FinishBenchmark();
+};
@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#pragma once
+
+#include "Tests/ShooterTestControllerBenchmark.h"
+#include "ShooterTestControllerMovementBenchmark.generated.h"
+
+class AShooterCharacter;
+
+/**
+* Headless benchmark of movement abilities.
+* It spawns BenchmarkPawns bots in the loaded map and scripts them through Teleport, WallJump, JetpackSprint and WallRun loops.
+* Their movement components are ticked by the controller itself, so that movement time is measured alone,
+* and results are written as JSON to BenchmarkOutput (Saved/Automation/MovementBenchmark.json by default).
+* With -BenchmarkMallocCounter in non-shipping builds, allocations are counted by a GMalloc proxy installed at startup,
+* only on the game thread while movement components are ticked, see FShooterBenchmarkMallocCounter.
+*/
+UCLASS()
+class UShooterTestControllerMovementBenchmark : public UShooterTestControllerBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnInit() override;
+
+protected:
+	// Settings, from command line
+	int32 NumPawns;
+	float WarmupSeconds;
+	float BenchmarkSeconds;
+
+	// Benchmark state
+	UPROPERTY()
+	TArray<AShooterCharacter*> Pawns;
+	double ElapsedSeconds;
+	bool bMeasuring;
+	TArray<double> FrameMovementMs;
+	uint64 WallTracesAtStart;
+	uint64 UsedPhysicalAtStart;
+	uint64 AllocationsAtStart;
+	uint64 AllocatedBytesAtStart;
+
+	virtual void OnTick(float TimeDelta) override;
+
+	// Spawns the bots once the game world is running, returns false if it's not ready yet
+	bool SpawnPawns();
+	// Requests abilities according to each bot's loop
+	void ScriptPawns(float TimeDelta);
+	// Ticks all movement components, returns elapsed milliseconds
+	double TickPawnsMovement(float TimeDelta);
+	// Writes the JSON report and ends the test
+	void FinishBenchmark();
+};
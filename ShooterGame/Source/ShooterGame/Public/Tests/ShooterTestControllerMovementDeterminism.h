@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc.All Rights Reserved.
+#pragma once
+
+#include "Tests/ShooterTestControllerBenchmark.h"
+#include "ShooterTestControllerMovementDeterminism.generated.h"
+
+class AShooterCharacter;
+
+/**
+* Checks that ability physics give the same result on a client and on its server, with bFixedAbilitySubsteps.
+* Runs on both sides of a client/server session. The server forces a correction of every client move it can,
+* and the client runs a JetpackSprint script while its frame rate is capped at several rates, then jittered.
+* The server location of every corrected move is compared with the client's replayed location for the same move,
+* see FShooterMovementReplayStats. The test fails if they diverge more than DeterminismTolerance cm,
+* and results are written as JSON to DeterminismOutput (Saved/Automation/MovementDeterminism.json by default).
+*/
+UCLASS()
+class UShooterTestControllerMovementDeterminism : public UShooterTestControllerBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnInit() override;
+
+protected:
+	// Script run at a given client frame rate
+	struct FDeterminismPhase
+	{
+		FString Name;
+		// Client frames per second, 0 for a random rate between 15 and 60 every frame
+		int32 FrameRate;
+		// Client replay stats at the end of the phase
+		uint32 MeasuredCorrections;
+		float MaxCorrectionError;
+		float AvgCorrectionError;
+	};
+
+	// Settings, from command line
+	int32 NumSteps;
+	float Tolerance;
+	float TimeoutSeconds;
+
+	// Test state
+	UPROPERTY()
+	AShooterCharacter* Pawn;
+	TArray<FDeterminismPhase> Phases;
+	int32 PhaseIndex;
+	int32 Step;
+	float NextStepTime;
+	float WaitSeconds;
+	float MaxFPSAtStart;
+	FRandomStream Jitter;
+
+	virtual void OnTick(float TimeDelta) override;
+
+	// [server] Forces client corrections and fixed ability substeps on every player
+	void TickServer();
+	// [client] Waits for the possessed pawn, returns false if it's not ready yet
+	bool FindPawn(float TimeDelta);
+	// [client] Starts the next phase, or finishes the test after the last one
+	void StartPhase(int32 NewPhaseIndex);
+	// Writes the JSON report and ends the test
+	void FinishTest();
+};
@@ -0,0 +1,167 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ShooterLagCompensation.generated.h"
+
+class AShooterCharacter;
+class AShooterWeapon_Instant;
+
+/** location of a character hitbox at a given server time */
+struct FShooterRewindSample
+{
+	/** server world time of the sample */
+	float Time;
+
+	/** actor location, the hitbox is rebuilt around it */
+	FVector Location;
+};
+
+/** fixed size ring buffer of hitbox samples for one character */
+struct FShooterRewindHistory
+{
+	/** samples, oldest overwritten first */
+	TArray<FShooterRewindSample> Samples;
+
+	/** index of the newest sample */
+	int32 Head;
+
+	/** number of valid samples */
+	int32 Num;
+
+	FShooterRewindHistory()
+		: Head(INDEX_NONE)
+		, Num(0)
+	{
+	}
+
+	/** adds a sample, overwriting the oldest one when full */
+	void Add(float Time, const FVector& Location);
+
+	/** interpolated location at Time, clamped to the recorded range. Returns false if there is no sample */
+	bool GetLocationAt(float Time, FVector& OutLocation) const;
+
+	/** i-th sample, 0 being the newest */
+	const FShooterRewindSample& GetSample(int32 Index) const { return Samples[(Head - Index + Samples.Num()) % Samples.Num()]; }
+};
+
+/** client side hit waiting for server validation */
+struct FShooterPendingHit
+{
+	/** weapon that fired, notified with the result */
+	TWeakObjectPtr<AShooterWeapon_Instant> Weapon;
+
+	/** hit reported by the client */
+	FHitResult Impact;
+
+	/** muzzle location on the server when the hit was received */
+	FVector Origin;
+
+	/** client aim and shot direction regenerated from it */
+	FVector AimDir;
+	FVector ShootDir;
+
+	/** random seed and spread of the shot, for FX replication */
+	int32 RandomSeed;
+	float ReticleSpread;
+
+	/** server world time seen by the client when firing */
+	float ShotTime;
+
+	/** scale for the target bounding box */
+	float Leeway;
+};
+
+/**
+ * Server side lag compensation for instant hit validation.
+ *
+ * Every server frame, the location of each character is recorded in a per character ring buffer,
+ * covering p.ShooterRewindMaxTime seconds at most. Client hits are checked against the hitbox
+ * rewound to the time the client fired at, instead of the current one, so the leeway only has
+ * to absorb interpolation errors rather than the whole latency.
+ *
+ * Hits received during a frame are queued and validated together at the end of it, grouped by target.
+ */
+UCLASS()
+class UShooterLagCompensation : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/**
+	 * Checks that a client side hit is within the target bounding box, scaled by Leeway,
+	 * as it was at ShotTime (server world time seen by the client when firing).
+	 * Targets without history are checked against their current bounding box.
+	 */
+	bool ValidateHit(const FHitResult& Impact, float ShotTime, float Leeway) const;
+
+	/**
+	 * Queues a client side hit for validation by the next batched pass, at the end of the server frame.
+	 * The weapon is notified with AShooterWeapon_Instant::OnHitValidated().
+	 */
+	void QueueHit(FShooterPendingHit&& Hit);
+
+	/**
+	 * Validates all queued hits in one pass. Hits are grouped by target, so that bounding box and
+	 * rewound location are computed once per target and shot time. Returns the number of confirmed hits.
+	 */
+	int32 ValidatePendingHits();
+
+	/** number of queued hits */
+	int32 GetNumPendingHits() const { return PendingHits.Num(); }
+
+	/** hits validated or rejected by batched passes since the world started */
+	uint64 GetNumValidatedHits() const { return NumValidatedHits; }
+	uint64 GetNumRejectedHits() const { return NumRejectedHits; }
+
+	/** recorded history of a character, null if there is none */
+	const FShooterRewindHistory* FindHistory(const AActor* Actor) const;
+
+	/** number of characters with a history */
+	int32 GetNumHistories() const { return Histories.Num(); }
+
+	/** memory used by histories, in bytes */
+	SIZE_T GetAllocatedSize() const;
+
+	/** ring buffer capacity, from p.ShooterRewindMaxTime and p.ShooterRewindSampleInterval */
+	static int32 GetHistoryCapacity();
+
+private:
+
+	/** histories, by character */
+	TMap<TWeakObjectPtr<const AActor>, FShooterRewindHistory> Histories;
+
+	/** hits waiting for the next batched validation */
+	TArray<FShooterPendingHit> PendingHits;
+
+	/** batched validation results */
+	uint64 NumValidatedHits;
+	uint64 NumRejectedHits;
+
+	/** start of the current throughput window, and results at that time */
+	double ThroughputWindowStart;
+	uint64 ValidatedHitsAtWindowStart;
+	uint64 RejectedHitsAtWindowStart;
+
+	/** is Location within HitBox, scaled by Leeway? */
+	static bool IsWithinHitBox(const FBox& HitBox, const FVector& Location, float Leeway);
+
+	/** records a new sample for every character, at most every p.ShooterRewindSampleInterval */
+	void RecordHistories();
+
+	/** server time of the last recorded frame */
+	float LastSampleTime;
+};
@@ -9,6 +9,27 @@
 class UProjectileMovementComponent;
 class USphereComponent;
 
+/** state of a pooled projectile, replicated so that clients park and restart their copy explicitly */
+USTRUCT()
+struct FShooterProjectilePoolState
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** incremented every time the pool fires the projectile again */
+	UPROPERTY()
+	uint8 Generation;
+
+	/** is the projectile in flight or exploding, rather than parked in the pool? */
+	UPROPERTY()
+	bool bActive;
+
+	FShooterProjectilePoolState()
+		: Generation(0)
+		, bActive(false)
+	{
+	}
+};
+
 // 
 UCLASS(Abstract, Blueprintable)
 class AShooterProjectile : public AActor
@@ -25,7 +46,19 @@ class AShooterProjectile : public AActor
 	UFUNCTION()
 	void OnImpact(const FHitResult& HitResult);
 
+	/** [server] restarts a pooled projectile for a new shot, instead of spawning one */
+	void Reactivate(const FTransform& SpawnTM, FVector& ShootDirection);
+
+	/** [server] hides and parks the projectile, until the pool reuses it */
+	void Deactivate();
+
+	/** is this projectile owned by UShooterProjectilePool? set before spawning finishes */
+	bool bPooled;
+
 private:
+	/** simulated projectiles use the class defaults of this actor */
+	friend class UShooterProjectileSimulation;
+
 	/** movement component */
 	UPROPERTY(VisibleDefaultsOnly, Category=Projectile)
 	UProjectileMovementComponent* MovementComp;
@@ -56,12 +89,35 @@ protected:
 	UFUNCTION()
 	void OnRep_Exploded();
 
+	/** pool state, only used by pooled projectiles */
+	UPROPERTY(Transient, ReplicatedUsing=OnRep_PoolState)
+	FShooterProjectilePoolState PoolState;
+
+	/** [client] the projectile has been parked in the pool, or fired again */
+	UFUNCTION()
+	void OnRep_PoolState();
+
 	/** trigger explosion */
 	void Explode(const FHitResult& Impact);
 
 	/** shutdown projectile and prepare for destruction */
 	void DisableAndDestroy();
 
+	/** handle for returning a pooled projectile to its pool */
+	FTimerHandle TimerHandle_ReturnToPool;
+
+	/** destroys the projectile after Seconds, or returns it to its pool */
+	void SetProjectileLife(float Seconds);
+
+	/** [server] gives the projectile back to its pool */
+	void ReturnToPool();
+
+	/** restarts movement and auto activated components, after a pool reuse */
+	void ResetComponents();
+
+	/** stops audio and particle components, before parking the projectile in the pool */
+	void StopComponents();
+
 	/** update velocity on client */
 	virtual void PostNetReceiveVelocity(const FVector& NewVelocity) override;
 
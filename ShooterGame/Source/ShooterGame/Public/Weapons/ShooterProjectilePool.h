@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterProjectilePool.generated.h"
+
+class AShooterProjectile;
+class AShooterWeapon_Projectile;
+
+/**
+ * Per world pool of projectile actors, on the server.
+ *
+ * A projectile that is done showing its explosion is hidden and made dormant, instead of being destroyed,
+ * and the next shot of the same class reuses it: no actor spawn, no new replication channel.
+ * Up to p.ShooterProjectilePoolSize idle projectiles are kept, the others are destroyed.
+ */
+UCLASS()
+class UShooterProjectilePool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** pool of the world, null if pooling is disabled (p.ShooterProjectilePool 0) */
+	static UShooterProjectilePool* Get(const UObject* WorldContextObject);
+
+	/** fires a projectile of ProjectileClass for Weapon, reusing an idle one if possible */
+	AShooterProjectile* SpawnProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTM, AShooterWeapon_Projectile* Weapon, FVector ShootDir);
+
+	/** takes back a projectile that is done, destroys it if the pool is full */
+	void Release(AShooterProjectile* Projectile);
+
+	/** number of idle projectiles */
+	int32 GetNumIdle() const { return IdleProjectiles.Num(); }
+
+private:
+
+	/** hidden, dormant projectiles waiting for reuse */
+	UPROPERTY(Transient)
+	TArray<AShooterProjectile*> IdleProjectiles;
+};
@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ShooterProjectileSimulation.generated.h"
+
+class AShooterProjectile;
+class AShooterWeapon_Projectile;
+class UParticleSystemComponent;
+
+/**
+ * Projectile without an actor, stepped by UShooterProjectileSimulation.
+ */
+struct FShooterSimulatedProjectile
+{
+	FVector Location;
+	FVector Velocity;
+	/** seconds before the projectile expires without exploding */
+	float TimeLeft;
+	/** identifies the projectile in spawn and explode events */
+	uint16 Id;
+	/** is the server simulating it, or is it a client side visual? */
+	bool bAuthority;
+
+	/** class defaults giving speed, collision and effects */
+	const AShooterProjectile* Defaults;
+
+	/** [server] damage */
+	int32 ExplosionDamage;
+	float ExplosionRadius;
+	TSubclassOf<UDamageType> DamageType;
+	TWeakObjectPtr<AController> Controller;
+	TWeakObjectPtr<AActor> Instigator;
+	/** [server] firing weapon, damage causer of the explosion */
+	TWeakObjectPtr<AShooterWeapon_Projectile> Weapon;
+
+	/** [client] trail effect */
+	TWeakObjectPtr<UParticleSystemComponent> TrailPSC;
+};
+
+/**
+ * Per world simulation of projectiles, used instead of projectile actors when p.ShooterSimulatedProjectiles is 1.
+ *
+ * The server steps every projectile of the world in a single contiguous array, sweeping them against the scene,
+ * and only spawn and explode events are replicated, through the always relevant game state.
+ * Clients step the same projectiles for visuals only: they never deal damage, and explosions come from the server.
+ */
+UCLASS()
+class UShooterProjectileSimulation : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** simulation of the world, null if simulated projectiles are disabled (p.ShooterSimulatedProjectiles 0) */
+	static UShooterProjectileSimulation* Get(const UObject* WorldContextObject);
+
+	/** [server] fires a simulated projectile, and notifies clients through the game state */
+	void FireProjectile(AShooterWeapon_Projectile* Weapon, const struct FProjectileWeaponData& WeaponConfig, const FVector& Origin, const FVector& ShootDir);
+
+	/** [client] starts the visual of a projectile fired on the server */
+	void SimulateProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FVector& Origin, const FVector& ShootDir, uint16 ProjectileId, float ProjectileLife);
+
+	/** [client] a projectile exploded on the server: stops its visual and plays the explosion */
+	void ExplodeProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, uint16 ProjectileId, const FVector& ImpactPoint, const FVector& ImpactNormal);
+
+	/** number of projectiles being simulated */
+	int32 GetNumProjectiles() const { return Projectiles.Num(); }
+
+private:
+
+	/** all projectiles, server and client side ones */
+	TArray<FShooterSimulatedProjectile> Projectiles;
+
+	/** next projectile id, wraps around */
+	uint16 NextId;
+
+	/** adds a projectile and its trail effect */
+	FShooterSimulatedProjectile& AddProjectile(const AShooterProjectile* Defaults, const FVector& Origin, const FVector& ShootDir, uint16 ProjectileId, bool bAuthority);
+
+	/** [server] deals damage and notifies clients */
+	void Explode(const FShooterSimulatedProjectile& Projectile, const FHitResult& Impact);
+
+	/** plays the explosion effect of a projectile class */
+	void SpawnExplosionEffect(const AShooterProjectile* Defaults, const FHitResult& Impact);
+
+	/** removes a projectile, stopping its trail */
+	void RemoveProjectile(int32 Index);
+};
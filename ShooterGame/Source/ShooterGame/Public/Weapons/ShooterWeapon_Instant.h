@@ -6,6 +6,7 @@
 #include "ShooterWeapon_Instant.generated.h"
 
 class AShooterImpactEffect;
+class UPhysicalMaterial;
 
 USTRUCT()
 struct FInstantHitInfo
@@ -15,6 +16,10 @@ struct FInstantHitInfo
 	UPROPERTY()
 	FVector Origin;
 
+	/** aim of the shooter, remote clients regenerate the shot directions from it instead of their replicated view */
+	UPROPERTY()
+	FVector_NetQuantizeNormal AimDir;
+
 	UPROPERTY()
 	float ReticleSpread;
 
@@ -23,12 +28,74 @@ struct FInstantHitInfo
 
 	FInstantHitInfo()
 		: Origin(0)
+		, AimDir(0)
 		, ReticleSpread(0)
 		, RandomSeed(0)
 	{
 	}
 };
 
+/**
+ * compact client side hit report, replacing a whole FHitResult in hit RPCs.
+ * The shot direction isn't sent: the server regenerates it from the client aim and the shot random seed.
+ */
+USTRUCT()
+struct FShooterHitReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** hit actor, sent as a net id. Null for world geometry */
+	UPROPERTY()
+	AActor* Actor;
+
+	/** quantized impact location */
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	/** bone of the hit actor mesh, INDEX_NONE if none */
+	UPROPERTY()
+	int16 BoneIndex;
+
+	/** index of the pellet in multi-pellet shots, 0 otherwise */
+	UPROPERTY()
+	uint8 PelletIndex;
+
+	/** client aim of single shots. Zero in pellet hits, ServerNotifyPelletHits sends it once for all pellets */
+	UPROPERTY()
+	FVector_NetQuantizeNormal AimDir;
+
+	/** surface hit, for impact FX. Null if unknown */
+	UPROPERTY()
+	TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;
+
+	FShooterHitReport()
+		: Actor(nullptr)
+		, Location(0)
+		, BoneIndex(INDEX_NONE)
+		, PelletIndex(0)
+		, AimDir(0)
+	{
+	}
+
+	/** builds the report of a client side hit */
+	static FShooterHitReport FromHitResult(const FHitResult& Impact, uint8 InPelletIndex = 0);
+
+	/** [server] rebuilds the hit, ShootDir being regenerated from the client aim and the shot random seed */
+	FHitResult ToHitResult(const FVector& ShootDir) const;
+
+	/** actor net id, location, then bone, pellet, aim and surface only when set */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterHitReport> : public TStructOpsTypeTraitsBase2<FShooterHitReport>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 USTRUCT()
 struct FInstantWeaponData
 {
@@ -62,6 +129,14 @@ struct FInstantWeaponData
 	UPROPERTY(EditDefaultsOnly, Category=WeaponStat)
 	TSubclassOf<UDamageType> DamageType;
 
+	/** number of pellets per shot, each dealing HitDamage */
+	UPROPERTY(EditDefaultsOnly, Category=WeaponStat, meta=(ClampMin="1", ClampMax="32"))
+	int32 PelletCount;
+
+	/** multi-pellet shots: spread added to the weapon spread (degrees) */
+	UPROPERTY(EditDefaultsOnly, Category=Accuracy)
+	float PelletSpread;
+
 	/** hit verification: scale for bounding box of hit actor */
 	UPROPERTY(EditDefaultsOnly, Category=HitVerification)
 	float ClientSideHitLeeway;
@@ -80,6 +155,8 @@ struct FInstantWeaponData
 		WeaponRange = 10000.0f;
 		HitDamage = 10;
 		DamageType = UDamageType::StaticClass();
+		PelletCount = 1;
+		PelletSpread = 0.0f;
 		ClientSideHitLeeway = 200.0f;
 		AllowedViewDotHitDir = 0.8f;
 	}
@@ -94,6 +171,9 @@ class AShooterWeapon_Instant : public AShooterWeapon
 	/** get current spread */
 	float GetCurrentSpread() const;
 
+	/** [server] result of a client side hit queued for validation by ServerNotifyHit */
+	void OnHitValidated(const struct FShooterPendingHit& Hit, bool bConfirmed);
+
 protected:
 
 	virtual EAmmoType GetAmmoType() const override
@@ -127,19 +207,26 @@ protected:
 	//////////////////////////////////////////////////////////////////////////
 	// Weapon usage
 
-	/** server notified of hit from client to verify */
+	/** server notified of hit from client to verify, ShotTime is the server world time seen by the client when firing */
 	UFUNCTION(reliable, server, WithValidation)
-	void ServerNotifyHit(const FHitResult& Impact, FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ServerNotifyHit(const FShooterHitReport& HitReport, int32 RandomSeed, float ReticleSpread, float ShotTime);
 
-	/** server notified of miss to show trail FX */
+	/** server notified of miss to show trail FX, the shot direction is regenerated from the aim */
 	UFUNCTION(unreliable, server, WithValidation)
-	void ServerNotifyMiss(FVector_NetQuantizeNormal ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ServerNotifyMiss(FVector_NetQuantizeNormal AimDir, int32 RandomSeed, float ReticleSpread);
+
+	/** server notified of all pellet hits of a multi-pellet shot to verify, misses are simply left out */
+	UFUNCTION(reliable, server, WithValidation)
+	void ServerNotifyPelletHits(FVector_NetQuantizeNormal AimDir, int32 RandomSeed, float ReticleSpread, float ShotTime, const TArray<FShooterHitReport>& PelletHits);
+
+	/** [server] verify a client side hit, and process it if it's confirmed */
+	void ValidateClientHit(const FHitResult& Impact, const FVector& AimDir, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread, float ShotTime);
 
 	/** process the instant hit and notify the server if necessary */
-	void ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ProcessInstantHit(const FHitResult& Impact, const FVector& Origin, const FVector& AimDir, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread);
 
 	/** continue processing the instant hit, as if it has been confirmed by the server */
-	void ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread);
+	void ProcessInstantHit_Confirmed(const FHitResult& Impact, const FVector& Origin, const FVector& AimDir, const FVector& ShootDir, int32 RandomSeed, float ReticleSpread);
 
 	/** check if weapon should deal damage to actor */
 	bool ShouldDealDamage(AActor* TestActor) const;
@@ -150,6 +237,15 @@ protected:
 	/** [local] weapon specific fire implementation */
 	virtual void FireWeapon() override;
 
+	/** [local] multi-pellet shot: all pellets are traced, and hits are sent to the server with a single RPC */
+	void FirePellets(const FVector& AimDir, const FVector& StartTrace, int32 RandomSeed, float ReticleSpread);
+
+	/** pellet directions of a shot, generated from its random seed */
+	void GetPelletDirections(const FVector& AimDir, int32 RandomSeed, float ReticleSpread, TArray<FVector, TInlineAllocator<32>>& OutDirections) const;
+
+	/** server time of the world seen by this client, so that the server can rewind targets to it */
+	float GetShotTime() const;
+
 	/** [local + server] update spread on firing */
 	virtual void OnBurstFinished() override;
 
@@ -161,7 +257,7 @@ protected:
 	void OnRep_HitNotify();
 
 	/** called in network play to do the cosmetic fx  */
-	void SimulateInstantHit(const FVector& Origin, int32 RandomSeed, float ReticleSpread);
+	void SimulateInstantHit(const FVector& Origin, const FVector& AimDir, int32 RandomSeed, float ReticleSpread);
 
 	/** spawn effects for impact */
 	void SpawnImpactEffects(const FHitResult& Impact);